@@ -0,0 +1,373 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/mobility-module.h"
+
+#include <chrono>
+#include <fstream>
+
+using namespace ns3;
+
+// One simulation per invocation, selected on the command line, appending one
+// CSV row of QoE and efficiency metrics to --output. Topologies:
+//   p2p       the server node has a link of its own to every client
+//   dumbbell  the clients share one bottleneck link to the server, their
+//             access links are 1Gbps, 1ms
+//   wifi      the server runs on the access point of the clients, the link
+//             rate and delay are those of the WiFi channel and are ignored
+// Both applications run over --transport, udp or tcp, so the two can be
+// compared on the same topology. With multicast, the server is a live origin
+// sending every level to a group of its own, and the clients join the group
+// of their level; it needs the dumbbell, where the router copies the groups
+// to every access link, or wifi.
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamBenchmark");
+
+// Group of level 0 in multicast mode, level l using the address plus l, and
+// the number of levels the routes are installed for.
+static const Ipv4Address MULTICAST_GROUP ("225.1.2.0");
+static const uint32_t MULTICAST_LEVELS = 16;
+
+static Address
+BuildP2p (Ptr<Node> server, NodeContainer clients, std::string dataRate, std::string delay)
+{
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+
+  InternetStackHelper stack;
+  stack.Install (server);
+  stack.Install (clients);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.252");
+  Ipv4InterfaceContainer interfaces;
+  for (uint32_t i = 0; i < clients.GetN (); i++)
+    {
+      interfaces = address.Assign (pointToPoint.Install (server, clients.Get (i)));
+      address.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  // The server answers on any of its interfaces.
+  return interfaces.GetAddress (0);
+}
+
+static Address
+BuildDumbbell (Ptr<Node> server, NodeContainer clients, std::string dataRate, std::string delay, bool multicast)
+{
+  NodeContainer router;
+  router.Create (1);
+
+  InternetStackHelper stack;
+  stack.Install (server);
+  stack.Install (router);
+  stack.Install (clients);
+
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  bottleneck.SetChannelAttribute ("Delay", StringValue (delay));
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  access.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.252");
+  NetDeviceContainer bottleneckDevices = bottleneck.Install (server, router.Get (0));
+  Ipv4InterfaceContainer serverInterfaces = address.Assign (bottleneckDevices);
+  NetDeviceContainer accessDevices;
+  for (uint32_t i = 0; i < clients.GetN (); i++)
+    {
+      address.NewNetwork ();
+      NetDeviceContainer devices = access.Install (router.Get (0), clients.Get (i));
+      address.Assign (devices);
+      accessDevices.Add (devices.Get (0));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  if (multicast)
+    {
+      // The groups cross the bottleneck once and the router copies them to
+      // every access link.
+      Ipv4StaticRoutingHelper multicastRouting;
+      multicastRouting.SetDefaultMulticastRoute (server, bottleneckDevices.Get (0));
+      for (uint32_t level = 0; level < MULTICAST_LEVELS; level++)
+        {
+          multicastRouting.AddMulticastRoute (router.Get (0), Ipv4Address::GetAny (), Ipv4Address (MULTICAST_GROUP.Get () + level),
+                                              bottleneckDevices.Get (1), accessDevices);
+        }
+    }
+  return serverInterfaces.GetAddress (0);
+}
+
+static Address
+BuildWifi (Ptr<Node> server, NodeContainer clients, bool multicast)
+{
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+
+  WifiHelper wifi;
+  wifi.SetRemoteStationManager ("ns3::AarfWifiManager");
+
+  WifiMacHelper mac;
+  Ssid ssid = Ssid ("ns-3-aqiao");
+  mac.SetType ("ns3::StaWifiMac",
+               "Ssid", SsidValue (ssid),
+               "ActiveProbing", BooleanValue (false));
+  NetDeviceContainer staDevices = wifi.Install (phy, mac, clients);
+
+  mac.SetType ("ns3::ApWifiMac",
+               "Ssid", SsidValue (ssid));
+  NetDeviceContainer apDevices = wifi.Install (phy, mac, server);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (5.0),
+                                 "DeltaY", DoubleValue (5.0),
+                                 "GridWidth", UintegerValue (10),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (server);
+  mobility.Install (clients);
+
+  InternetStackHelper stack;
+  stack.Install (server);
+  stack.Install (clients);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.0.0");
+  Ipv4InterfaceContainer apInterfaces = address.Assign (apDevices);
+  address.Assign (staDevices);
+  if (multicast)
+    {
+      Ipv4StaticRoutingHelper multicastRouting;
+      multicastRouting.SetDefaultMulticastRoute (server, apDevices.Get (0));
+    }
+  return apInterfaces.GetAddress (0);
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string topology = "p2p";
+  std::string dataRate = "10Mbps";
+  std::string delay = "2ms";
+  uint32_t clients = 1;
+  double speed = 1.8;
+  std::string abr = "throughput";
+  bool adaptiveSpeed = false;
+  bool live = false;
+  std::string transport = "udp";
+  bool rateControl = false;
+  uint32_t packetSize = 1400;
+  uint32_t seed = 1;
+  double duration = 100.0;
+  std::string output = "videoStreamBenchmark.csv";
+
+  CommandLine cmd;
+  cmd.AddValue ("topology", "Network topology: p2p, dumbbell or wifi", topology);
+  cmd.AddValue ("dataRate", "Rate of the client links (p2p) or of the bottleneck (dumbbell)", dataRate);
+  cmd.AddValue ("delay", "Delay of the client links (p2p) or of the bottleneck (dumbbell)", delay);
+  cmd.AddValue ("clients", "Number of clients", clients);
+  cmd.AddValue ("speed", "Playback speed of the clients", speed);
+  cmd.AddValue ("abr", "ABR algorithm of the clients: throughput, bola or mpc", abr);
+  cmd.AddValue ("adaptiveSpeed", "Let the clients adjust their speed around the playback speed", adaptiveSpeed);
+  cmd.AddValue ("live", "Let the server produce the frames in real time", live);
+  cmd.AddValue ("transport", "Transport of the applications: udp, tcp or multicast (UDP, dumbbell or wifi)", transport);
+  cmd.AddValue ("rateControl", "Let the server set the UDP send rate of every client from its receiver reports", rateControl);
+  cmd.AddValue ("packetSize", "MaxPacketSize of the server", packetSize);
+  cmd.AddValue ("seed", "Seed of the random number generators", seed);
+  cmd.AddValue ("duration", "Simulated seconds", duration);
+  cmd.AddValue ("output", "CSV file the row of the run is appended to", output);
+  cmd.Parse (argc, argv);
+
+  std::string abrType;
+  if (abr == "throughput")
+    {
+      abrType = "ns3::ThroughputAbr";
+    }
+  else if (abr == "bola")
+    {
+      abrType = "ns3::BolaAbr";
+    }
+  else if (abr == "mpc")
+    {
+      abrType = "ns3::MpcAbr";
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown ABR algorithm " << abr);
+    }
+
+  TypeId protocol;
+  bool multicast = transport == "multicast";
+  if (transport == "udp" || multicast)
+    {
+      protocol = UdpSocketFactory::GetTypeId ();
+    }
+  else if (transport == "tcp")
+    {
+      protocol = TcpSocketFactory::GetTypeId ();
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown transport " << transport);
+    }
+
+  Time::SetResolution (Time::NS);
+  RngSeedManager::SetSeed (seed);
+  Config::SetDefault ("ns3::VideoStreamClient::PlaybackSpeed", DoubleValue (speed));
+  Config::SetDefault ("ns3::VideoStreamClient::AbrAlgorithm", StringValue (abrType));
+  Config::SetDefault ("ns3::VideoStreamClient::AdaptiveSpeed", BooleanValue (adaptiveSpeed));
+  Config::SetDefault ("ns3::VideoStreamServer::MaxPacketSize", UintegerValue (packetSize));
+  Config::SetDefault ("ns3::VideoStreamServer::Live", BooleanValue (live));
+  Config::SetDefault ("ns3::VideoStreamServer::Protocol", TypeIdValue (protocol));
+  Config::SetDefault ("ns3::VideoStreamClient::Protocol", TypeIdValue (protocol));
+  Config::SetDefault ("ns3::VideoStreamServer::RateControl", BooleanValue (rateControl));
+  if (multicast)
+    {
+      Config::SetDefault ("ns3::VideoStreamServer::MulticastGroup", Ipv4AddressValue (MULTICAST_GROUP));
+      Config::SetDefault ("ns3::VideoStreamClient::Multicast", BooleanValue (true));
+    }
+
+  NodeContainer serverNode;
+  serverNode.Create (1);
+  NodeContainer clientNodes;
+  clientNodes.Create (clients);
+
+  Address serverAddress;
+  if (topology == "p2p")
+    {
+      if (multicast)
+        {
+          NS_FATAL_ERROR ("Multicast needs the dumbbell or wifi topology");
+        }
+      serverAddress = BuildP2p (serverNode.Get (0), clientNodes, dataRate, delay);
+    }
+  else if (topology == "dumbbell")
+    {
+      serverAddress = BuildDumbbell (serverNode.Get (0), clientNodes, dataRate, delay, multicast);
+    }
+  else if (topology == "wifi")
+    {
+      serverAddress = BuildWifi (serverNode.Get (0), clientNodes, multicast);
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology);
+    }
+
+  VideoStreamServerHelper videoServer (5000);
+  // Pace every client at the rate of its own link, so that its bursts do
+  // not overflow the link queue. On the dumbbell all clients share one
+  // link, whose rate also caps the server.
+  if (topology == "p2p" || topology == "dumbbell")
+    {
+      videoServer.SetAttribute ("PacingRate", DataRateValue (DataRate (dataRate)));
+    }
+  if (topology == "dumbbell")
+    {
+      videoServer.SetAttribute ("ServerPacingRate", DataRateValue (DataRate (dataRate)));
+    }
+  ApplicationContainer serverApps = videoServer.Install (serverNode.Get (0));
+  serverApps.Start (Seconds (0.0));
+  serverApps.Stop (Seconds (duration));
+
+  VideoStreamClientHelper videoClient (serverAddress, 5000);
+  ApplicationContainer clientApps = videoClient.Install (clientNodes);
+  clientApps.Start (Seconds (0.5));
+  clientApps.Stop (Seconds (duration));
+
+  Ptr<VideoStreamQoeCollector> qoe = CreateObject<VideoStreamQoeCollector> ();
+  qoe->Install (serverApps);
+  qoe->Install (clientApps);
+
+  Simulator::Stop (Seconds (duration));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wallClock = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  uint64_t events = Simulator::GetEventCount ();
+
+  // Session metrics are averaged over the sessions, byte counts are summed.
+  // The fairness is Jain's index of the bytes the sessions received.
+  uint32_t started = 0;
+  double startupDelay = 0, stalls = 0, rebufferRatio = 0, bitrate = 0, switches = 0, latency = 0;
+  uint64_t rxBytes = 0, wastedBytes = 0;
+  double squares = 0;
+  for (uint32_t i = 0; i < qoe->GetNSessions (); i++)
+    {
+      const VideoStreamQoeCollector::SessionStats &stats = qoe->GetSessionStats (i);
+      if (stats.m_started)
+        {
+          started++;
+          startupDelay += stats.m_startupDelay.GetSeconds ();
+        }
+      stalls += stats.m_stalls;
+      rebufferRatio += stats.GetRebufferRatio ();
+      bitrate += stats.GetAverageBitrate ();
+      switches += stats.m_switches;
+      latency += stats.GetAverageLatency ().GetSeconds ();
+      rxBytes += stats.m_rxBytes;
+      squares += (double) stats.m_rxBytes * stats.m_rxBytes;
+      wastedBytes += stats.m_wastedBytes;
+    }
+  uint64_t sentBytes = 0, retransmittedBytes = 0;
+  const std::map<Address, VideoStreamQoeCollector::PeerStats> &peers = qoe->GetPeerStats ();
+  for (std::map<Address, VideoStreamQoeCollector::PeerStats>::const_iterator it = peers.begin (); it != peers.end (); it++)
+    {
+      sentBytes += it->second.m_sentBytes;
+      retransmittedBytes += it->second.m_retransmittedBytes;
+    }
+  Simulator::Destroy ();
+  double fairness = squares > 0 ? (double) rxBytes * rxBytes / (clients * squares) : 0;
+
+  std::ifstream existing (output.c_str ());
+  bool header = existing.peek () == std::ifstream::traits_type::eof ();
+  existing.close ();
+  std::ofstream csv (output.c_str (), std::ios::app);
+  if (header)
+    {
+      csv << "topology,dataRate,delay,clients,speed,abr,adaptiveSpeed,live,transport,rateControl,packetSize,seed,duration,"
+          << "startedSessions,startupDelay,stalls,rebufferRatio,averageBitrate,switches,averageLatency,"
+          << "rxBytes,wastedBytes,sentBytes,retransmittedBytes,goodputMbps,fairness,"
+          << "wallClockSeconds,events,eventsPerSecond,speedup" << std::endl;
+    }
+  csv << topology << ","
+      << dataRate << ","
+      << delay << ","
+      << clients << ","
+      << speed << ","
+      << abr << ","
+      << adaptiveSpeed << ","
+      << live << ","
+      << transport << ","
+      << rateControl << ","
+      << packetSize << ","
+      << seed << ","
+      << duration << ","
+      << started << ","
+      << (started ? startupDelay / started : 0) << ","
+      << stalls / clients << ","
+      << rebufferRatio / clients << ","
+      << bitrate / clients << ","
+      << switches / clients << ","
+      << latency / clients << ","
+      << rxBytes << ","
+      << wastedBytes << ","
+      << sentBytes << ","
+      << retransmittedBytes << ","
+      << rxBytes * 8.0 / duration / 1e6 << ","
+      << fairness << ","
+      << wallClock << ","
+      << events << ","
+      << (wallClock > 0 ? events / wallClock : 0) << ","
+      << (wallClock > 0 ? duration / wallClock : 0) << std::endl;
+
+  std::cerr << "Simulated " << duration << "s in " << wallClock << "s of wall clock, "
+            << events << " events (" << (wallClock > 0 ? events / wallClock : 0) << " per second)" << std::endl;
+  return 0;
+}
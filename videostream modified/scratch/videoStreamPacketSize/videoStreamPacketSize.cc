@@ -0,0 +1,179 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/mobility-module.h"
+
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+// Compares MaxPacketSize values on the WiFi case (CASE 3 of videoStreamTest):
+// a fragment larger than the MTU is split by IP, and losing any IP fragment
+// loses the whole video fragment.
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamPacketSize");
+
+struct RunCounters
+{
+  uint64_t fragmentsSent;
+  uint64_t fragmentsReceived;
+  uint64_t bytesReceived;
+  uint64_t msdusSent;
+  uint64_t msdusReceived;
+};
+
+static RunCounters g_counters;
+
+static void
+FragmentSent (Ptr<const Packet> packet)
+{
+  g_counters.fragmentsSent++;
+}
+
+static void
+FragmentReceived (Ptr<const Packet> packet)
+{
+  g_counters.fragmentsReceived++;
+  g_counters.bytesReceived += packet->GetSize ();
+}
+
+static void
+MsduSent (Ptr<const Packet> packet)
+{
+  g_counters.msdusSent++;
+}
+
+static void
+MsduReceived (Ptr<const Packet> packet)
+{
+  g_counters.msdusReceived++;
+}
+
+static void
+RunWifi (uint32_t packetSize, double duration)
+{
+  g_counters = RunCounters ();
+
+  NodeContainer wifiStaNodes;
+  wifiStaNodes.Create (1);
+  NodeContainer wifiApNode;
+  wifiApNode.Create (1);
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+
+  WifiHelper wifi;
+  wifi.SetRemoteStationManager ("ns3::AarfWifiManager");
+
+  WifiMacHelper mac;
+  Ssid ssid = Ssid ("ns-3-aqiao");
+  mac.SetType ("ns3::StaWifiMac",
+               "Ssid", SsidValue (ssid),
+               "ActiveProbing", BooleanValue (false));
+  NetDeviceContainer staDevices = wifi.Install (phy, mac, wifiStaNodes);
+
+  mac.SetType ("ns3::ApWifiMac",
+               "Ssid", SsidValue (ssid));
+  NetDeviceContainer apDevices = wifi.Install (phy, mac, wifiApNode);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (30.0),
+                                 "DeltaY", DoubleValue (30.0),
+                                 "GridWidth", UintegerValue (2),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (wifiStaNodes);
+  mobility.Install (wifiApNode);
+
+  InternetStackHelper stack;
+  stack.Install (wifiApNode);
+  stack.Install (wifiStaNodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.3.0", "255.255.255.0");
+  Ipv4InterfaceContainer apInterfaces = address.Assign (apDevices);
+  address.Assign (staDevices);
+
+  VideoStreamServerHelper videoServer (5000);
+  videoServer.SetAttribute ("MaxPacketSize", UintegerValue (packetSize));
+  ApplicationContainer serverApps = videoServer.Install (wifiApNode.Get (0));
+  serverApps.Start (Seconds (0.0));
+  serverApps.Stop (Seconds (duration));
+
+  VideoStreamClientHelper videoClient (apInterfaces.GetAddress (0), 5000);
+  ApplicationContainer clientApps = videoClient.Install (wifiStaNodes.Get (0));
+  clientApps.Start (Seconds (0.5));
+  clientApps.Stop (Seconds (duration));
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  serverApps.Get (0)->TraceConnectWithoutContext ("Tx", MakeCallback (&FragmentSent));
+  clientApps.Get (0)->TraceConnectWithoutContext ("Rx", MakeCallback (&FragmentReceived));
+  std::ostringstream apMac;
+  apMac << "/NodeList/" << wifiApNode.Get (0)->GetId () << "/DeviceList/*/$ns3::WifiNetDevice/Mac/MacTx";
+  Config::ConnectWithoutContext (apMac.str (), MakeCallback (&MsduSent));
+  std::ostringstream staMac;
+  staMac << "/NodeList/" << wifiStaNodes.Get (0)->GetId () << "/DeviceList/*/$ns3::WifiNetDevice/Mac/MacRx";
+  Config::ConnectWithoutContext (staMac.str (), MakeCallback (&MsduReceived));
+
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  double duration = 30.0;
+  std::string packetSizes = "1400,30000";
+
+  CommandLine cmd;
+  cmd.AddValue ("duration", "Simulated seconds per run", duration);
+  cmd.AddValue ("packetSizes", "Comma separated MaxPacketSize values to compare", packetSizes);
+  cmd.Parse (argc, argv);
+
+  Time::SetResolution (Time::NS);
+
+  std::vector<uint32_t> sizes;
+  std::istringstream list (packetSizes);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      sizes.push_back (std::stoul (item));
+    }
+
+  std::cout << "packetSize,fragmentsSent,fragmentsReceived,fragmentLoss,msduLoss,lossAmplification,goodputMbps,wallClockSeconds,usPerFragment" << std::endl;
+  for (uint32_t packetSize : sizes)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+      RunWifi (packetSize, duration);
+      double wallClock = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+      double fragmentLoss = g_counters.fragmentsSent == 0 ? 0.0
+        : 1.0 - double (g_counters.fragmentsReceived) / g_counters.fragmentsSent;
+      double msduLoss = g_counters.msdusSent == 0 ? 0.0
+        : 1.0 - double (g_counters.msdusReceived) / g_counters.msdusSent;
+      double amplification = msduLoss > 0 ? fragmentLoss / msduLoss : 0.0;
+      double goodput = g_counters.bytesReceived * 8.0 / (duration - 0.5) / 1e6;
+
+      std::cout << packetSize << ","
+                << g_counters.fragmentsSent << ","
+                << g_counters.fragmentsReceived << ","
+                << fragmentLoss << ","
+                << msduLoss << ","
+                << amplification << ","
+                << goodput << ","
+                << wallClock << ","
+                << (g_counters.fragmentsSent == 0 ? 0.0 : wallClock * 1e6 / g_counters.fragmentsSent) << std::endl;
+    }
+
+  return 0;
+}
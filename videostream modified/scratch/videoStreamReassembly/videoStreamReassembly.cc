@@ -0,0 +1,74 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/applications-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+// Checks that the client can reassemble the largest frame of a trace: the
+// server announces the largest fragment count in the manifest, and the
+// client sizes its reassembly buffer from it. The frames of the top level
+// are fed in order up to the largest one, whose fragments are fed in reverse
+// order, to a reassembler built as the client builds it. The largest frame
+// must complete. Aborts otherwise.
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamReassembly");
+
+int
+main (int argc, char *argv[])
+{
+  std::string frameFile = "./scratch/videoStreamer/small.txt";
+  uint32_t packetSize = 1400;
+  uint32_t maxFragments = 256;
+  uint32_t window = 128;
+
+  CommandLine cmd;
+  cmd.AddValue ("frameFile", "Frame size trace of the server", frameFile);
+  cmd.AddValue ("packetSize", "MaxPacketSize of the server", packetSize);
+  cmd.AddValue ("maxFragments", "MaxFragmentsPerFrame of the client", maxFragments);
+  cmd.AddValue ("window", "ReassemblyWindow of the client", window);
+  cmd.Parse (argc, argv);
+
+  Ptr<const VideoFrameTrace> trace = VideoFrameTrace::Get (frameFile, packetSize - VideoStreamHeader ().GetSerializedSize ());
+  uint32_t level = trace->GetLevelCount () - 1;
+  uint32_t largest = 0;
+  for (uint32_t frame = 1; frame < trace->GetFrameCount (); frame++)
+    {
+      if (trace->GetFrameSize (level, frame) > trace->GetFrameSize (level, largest))
+        {
+          largest = frame;
+        }
+    }
+  uint32_t fragmentCount = trace->GetFragmentCount (level, largest);
+
+  // The manifest as the client receives it.
+  VideoStreamManifestHeader sent;
+  sent.SetMaxFragments (trace->GetMaxFragmentCount ());
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (sent);
+  VideoStreamManifestHeader manifest;
+  packet->RemoveHeader (manifest);
+
+  FrameReassembler reassembler (window, std::max<uint32_t> (maxFragments, manifest.GetMaxFragments ()));
+  reassembler.SetFec (manifest.GetFecGroupSize (), manifest.GetFecParity ());
+  for (uint32_t frame = 0; frame < largest; frame++)
+    {
+      for (uint32_t fragment = 0; fragment < trace->GetFragmentCount (level, frame); fragment++)
+        {
+          reassembler.AddFragment (frame, fragment, trace->GetFragmentCount (level, frame));
+        }
+    }
+  for (uint32_t fragment = fragmentCount; fragment-- > 0;)
+    {
+      reassembler.AddFragment (largest, fragment, fragmentCount);
+    }
+
+  std::cout << "Frame " << largest << " of level " << level << ": " << trace->GetFrameSize (level, largest)
+            << " bytes in " << fragmentCount << " fragments, manifest announces "
+            << manifest.GetMaxFragments () << std::endl;
+  NS_ABORT_MSG_UNLESS (reassembler.IsComplete (largest), "Frame " << largest << " of level " << level
+                       << " did not reassemble, watermark at frame " << reassembler.GetWatermark ());
+  std::cout << "Reassembled" << std::endl;
+  return 0;
+}
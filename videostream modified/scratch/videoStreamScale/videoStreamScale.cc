@@ -0,0 +1,197 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+// Client scalability of the video streaming applications: one server with a
+// point-to-point link of its own to each of N clients (a star), N swept over
+// --clients. The clients are installed at once on a NodeContainer and start
+// at uniformly random times over --startWindow. Every run appends a row to
+// --output with the CPU time per simulated second and the peak RSS, and
+// writes the QoE of every client to <qoePrefix><N>.csv.
+//
+// Everything runs in one process, so the CPU time covers the network stack
+// as well as the applications, and the peak RSS is the largest of all runs
+// so far. The runs go by increasing N, so it is the one of the largest run.
+//
+// The clients print their progress on stdout: redirect it for large N.
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamScale");
+
+struct ResourceUsage
+{
+  double cpuSeconds;  // user and system time of the process
+  double peakRssMb;   // largest resident set size so far
+};
+
+static ResourceUsage
+GetResourceUsage (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  ResourceUsage result;
+  result.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+    + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+  // Linux reports kilobytes.
+  result.peakRssMb = usage.ru_maxrss / 1024.0;
+  return result;
+}
+
+static void
+RunStar (uint32_t clients, std::string dataRate, std::string delay, double startWindow,
+         double duration, std::string qoePrefix, std::ofstream &output)
+{
+  std::chrono::steady_clock::time_point setupStart = std::chrono::steady_clock::now ();
+
+  NodeContainer serverNode;
+  serverNode.Create (1);
+  NodeContainer clientNodes;
+  clientNodes.Create (clients);
+
+  InternetStackHelper stack;
+  stack.Install (serverNode);
+  stack.Install (clientNodes);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (delay));
+
+  // The server reaches every client over a connected route. The clients have
+  // a single link, so a default route through it is all they need, and the
+  // global routing computation, quadratic in the node count, is skipped.
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+  Ipv4StaticRoutingHelper staticRouting;
+  Ipv4Address serverAddress;
+  for (uint32_t i = 0; i < clients; i++)
+    {
+      Ipv4InterfaceContainer interfaces = address.Assign (pointToPoint.Install (serverNode.Get (0), clientNodes.Get (i)));
+      address.NewNetwork ();
+      staticRouting.GetStaticRouting (clientNodes.Get (i)->GetObject<Ipv4> ())->SetDefaultRoute (interfaces.GetAddress (0), 1);
+      if (i == 0)
+        {
+          serverAddress = interfaces.GetAddress (0);
+        }
+    }
+
+  VideoStreamServerHelper videoServer (5000);
+  ApplicationContainer serverApps = videoServer.Install (serverNode.Get (0));
+  serverApps.Start (Seconds (0.0));
+  serverApps.Stop (Seconds (duration));
+
+  VideoStreamClientHelper videoClient (serverAddress, 5000);
+  ApplicationContainer clientApps = videoClient.Install (clientNodes);
+  Ptr<UniformRandomVariable> startTime = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < clientApps.GetN (); i++)
+    {
+      clientApps.Get (i)->SetStartTime (Seconds (0.5 + startTime->GetValue (0, startWindow)));
+    }
+  clientApps.Stop (Seconds (duration));
+
+  Ptr<VideoStreamQoeCollector> qoe = CreateObject<VideoStreamQoeCollector> ();
+  qoe->Install (serverApps);
+  qoe->Install (clientApps);
+
+  double setup = std::chrono::duration<double> (std::chrono::steady_clock::now () - setupStart).count ();
+  ResourceUsage before = GetResourceUsage ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+  double wallClock = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  ResourceUsage after = GetResourceUsage ();
+  uint64_t events = Simulator::GetEventCount ();
+
+  std::ostringstream qoeFile;
+  qoeFile << qoePrefix << clients << ".csv";
+  std::ofstream sessions (qoeFile.str ().c_str ());
+  qoe->WriteSessions (sessions);
+
+  uint32_t started = 0;
+  double startupDelay = 0, rebufferRatio = 0, bitrate = 0;
+  for (uint32_t i = 0; i < qoe->GetNSessions (); i++)
+    {
+      const VideoStreamQoeCollector::SessionStats &stats = qoe->GetSessionStats (i);
+      if (stats.m_started)
+        {
+          started++;
+          startupDelay += stats.m_startupDelay.GetSeconds ();
+        }
+      rebufferRatio += stats.GetRebufferRatio ();
+      bitrate += stats.GetAverageBitrate ();
+    }
+  Simulator::Destroy ();
+
+  double cpu = after.cpuSeconds - before.cpuSeconds;
+  output << clients << ","
+         << duration << ","
+         << setup << ","
+         << wallClock << ","
+         << cpu << ","
+         << cpu / duration << ","
+         << cpu / duration / clients * 1e6 << ","
+         << after.peakRssMb << ","
+         << events << ","
+         << (wallClock > 0 ? events / wallClock : 0) << ","
+         << started << ","
+         << (started ? startupDelay / started : 0) << ","
+         << rebufferRatio / clients << ","
+         << bitrate / clients << std::endl;
+  std::cerr << clients << " clients: " << cpu / duration << " CPU seconds per simulated second, "
+            << after.peakRssMb << " MB peak RSS" << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string clientCounts = "10,100,1000,10000";
+  std::string dataRate = "10Mbps";
+  std::string delay = "2ms";
+  double startWindow = 10.0;
+  double duration = 60.0;
+  std::string output = "videoStreamScale.csv";
+  std::string qoePrefix = "videoStreamScale-qoe-";
+
+  CommandLine cmd;
+  cmd.AddValue ("clients", "Comma separated client counts to run", clientCounts);
+  cmd.AddValue ("dataRate", "Rate of the link of every client", dataRate);
+  cmd.AddValue ("delay", "Delay of the link of every client", delay);
+  cmd.AddValue ("startWindow", "Seconds over which the client start times are spread", startWindow);
+  cmd.AddValue ("duration", "Simulated seconds per run", duration);
+  cmd.AddValue ("output", "CSV file receiving one row per client count", output);
+  cmd.AddValue ("qoePrefix", "Prefix of the per-client QoE files, the client count is appended", qoePrefix);
+  cmd.Parse (argc, argv);
+
+  Time::SetResolution (Time::NS);
+  // Pace every client at the rate of its own link.
+  Config::SetDefault ("ns3::VideoStreamServer::PacingRate", DataRateValue (DataRate (dataRate)));
+
+  std::vector<uint32_t> counts;
+  std::istringstream list (clientCounts);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      counts.push_back (std::stoul (item));
+    }
+  std::sort (counts.begin (), counts.end ());
+
+  std::ofstream file (output.c_str ());
+  file << "clients,duration,setupSeconds,wallClockSeconds,cpuSeconds,cpuPerSimSecond,cpuUsPerClientSecond,"
+       << "peakRssMb,events,eventsPerSecond,startedSessions,startupDelay,rebufferRatio,averageBitrate" << std::endl;
+  for (uint32_t clients : counts)
+    {
+      RunStar (clients, dataRate, delay, startWindow, duration, qoePrefix, file);
+    }
+
+  return 0;
+}
@@ -8,23 +8,137 @@
 #include "ns3/csma-module.h"
 #include "ns3/netanim-module.h"
 
-using namespace ns3;
+#include <fstream>
 
-#define CASE 1
+using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("VideoStreamTest");
 
+static uint32_t g_queueDrops = 0;
+static uint64_t g_fragmentsSent = 0;
+static uint64_t g_paritySent = 0;
+static uint64_t g_retransmitted = 0;
+static uint64_t g_recovered = 0;
+static Ptr<VideoStreamQoeCollector> g_qoe;
+
+static void
+DeviceQueueOccupancy (uint32_t oldValue, uint32_t newValue)
+{
+  NS_LOG_UNCOND ("3\t" << Simulator::Now ().GetSeconds () << "\t" << newValue);
+}
+
+static void
+DeviceQueueDrop (Ptr<const Packet> packet)
+{
+  NS_LOG_UNCOND ("4\t" << Simulator::Now ().GetSeconds () << "\t" << ++g_queueDrops);
+}
+
+static void
+ServerFairness (double fairness)
+{
+  NS_LOG_UNCOND ("5\t" << Simulator::Now ().GetSeconds () << "\t" << fairness);
+}
+
+static void
+FragmentSent (Ptr<const Packet> packet)
+{
+  g_fragmentsSent++;
+}
+
+// The counters below are TracedValues of every application: sum their steps.
+static void
+ParitySent (uint32_t oldValue, uint32_t newValue)
+{
+  g_paritySent += newValue - oldValue;
+}
+
+static void
+FragmentRetransmitted (uint32_t oldValue, uint32_t newValue)
+{
+  g_retransmitted += newValue - oldValue;
+}
+
+static void
+FragmentRecovered (uint32_t oldValue, uint32_t newValue)
+{
+  g_recovered += newValue - oldValue;
+}
+
+static void
+ConnectFecCounters (void)
+{
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::VideoStreamServer/Tx",
+                                 MakeCallback (&FragmentSent));
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::VideoStreamServer/ParityFragments",
+                                 MakeCallback (&ParitySent));
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::VideoStreamServer/RetransmittedFragments",
+                                 MakeCallback (&FragmentRetransmitted));
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::VideoStreamClient/RecoveredFragments",
+                                 MakeCallback (&FragmentRecovered));
+}
+
+// Print the bandwidth spent on parity against the losses it repaired without
+// a NACK round trip.
+static void
+ReportFec (void)
+{
+  uint64_t dataSent = g_fragmentsSent - g_paritySent;
+  uint64_t repaired = g_recovered + g_retransmitted;
+  std::cout << "FEC overhead: " << (dataSent ? double (g_paritySent) / dataSent : 0)
+            << " (" << g_paritySent << " parity / " << dataSent << " data fragments)" << std::endl;
+  std::cout << "FEC recovery rate: " << (repaired ? double (g_recovered) / repaired : 0)
+            << " (" << g_recovered << " recovered / " << g_retransmitted << " retransmitted fragments)" << std::endl;
+}
+
+// Collect the QoE of every video application installed so far.
+static void
+InstallQoeCollector (void)
+{
+  g_qoe = CreateObject<VideoStreamQoeCollector> ();
+  for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End (); node++)
+    {
+      for (uint32_t i = 0; i < (*node)->GetNApplications (); i++)
+        {
+          g_qoe->Install (ApplicationContainer ((*node)->GetApplication (i)));
+        }
+    }
+}
+
+// Write one CSV row per client session, before the applications are destroyed.
+static void
+WriteQoe (std::string fileName)
+{
+  std::ofstream file (fileName.c_str ());
+  g_qoe->WriteSessions (file);
+  std::cout << "QoE of " << g_qoe->GetNSessions () << " sessions written to " << fileName << std::endl;
+}
+
 int
 main (int argc, char *argv[])
 {
+  uint16_t fecGroupSize = 8;
+  uint16_t fecParity = 0;
+  std::string qoeFile = "videoStream-qoe.csv";
+  uint32_t scenario = 1;
+  double speed = 1.8;
+
   CommandLine cmd;
+  cmd.AddValue ("case", "Network configuration: 1 P2P, 2 P2P with two clients, 3 WiFi, 4 WiFi with three access points", scenario);
+  cmd.AddValue ("speed", "Playback speed of the clients", speed);
+  cmd.AddValue ("fecGroupSize", "Data fragments per FEC group", fecGroupSize);
+  cmd.AddValue ("fecParity", "Parity fragments per FEC group, 0 disables FEC", fecParity);
+  cmd.AddValue ("qoeFile", "CSV file receiving the QoE of every client session", qoeFile);
   cmd.Parse (argc, argv);
-  
+
+  Config::SetDefault ("ns3::VideoStreamServer::FecGroupSize", UintegerValue (fecGroupSize));
+  Config::SetDefault ("ns3::VideoStreamServer::FecParity", UintegerValue (fecParity));
+  Config::SetDefault ("ns3::VideoStreamClient::PlaybackSpeed", DoubleValue (speed));
+
   Time::SetResolution (Time::NS);
   LogComponentEnable ("VideoStreamClientApplication", LOG_LEVEL_INFO);
   LogComponentEnable ("VideoStreamServerApplication", LOG_LEVEL_INFO);
 
-  if (CASE == 1)
+  if (scenario == 1)
   {
     NodeContainer nodes;
     nodes.Create (2);
@@ -56,11 +170,14 @@ main (int argc, char *argv[])
     serverApp.Stop (Seconds (100.0));
 
     pointToPoint.EnablePcap ("videoStream", devices.Get (1), false);
+    ConnectFecCounters ();
+    InstallQoeCollector ();
     Simulator::Run ();
+    WriteQoe (qoeFile);
     Simulator::Destroy ();
   }
 
-  else if (CASE == 2)
+  else if (scenario == 2)
   {
     NodeContainer nodes;
     nodes.Create (3);
@@ -100,17 +217,29 @@ main (int argc, char *argv[])
     VideoStreamServerHelper videoServer (5000);
     videoServer.SetAttribute ("MaxPacketSize", UintegerValue (1400));
     videoServer.SetAttribute ("FrameFile", StringValue ("./scratch/videoStreamer/small.txt"));
+    // Pace every client at the rate of its own link.
+    videoServer.SetAttribute ("PacingRate", DataRateValue (DataRate ("2Mbps")));
 
     ApplicationContainer serverApp = videoServer.Install (nodes.Get (0));
     serverApp.Start (Seconds (0.0));
     serverApp.Stop (Seconds (100.0));
 
+    Config::ConnectWithoutContext ("/NodeList/0/DeviceList/*/$ns3::PointToPointNetDevice/TxQueue/PacketsInQueue",
+                                   MakeCallback (&DeviceQueueOccupancy));
+    Config::ConnectWithoutContext ("/NodeList/0/DeviceList/*/$ns3::PointToPointNetDevice/TxQueue/Drop",
+                                   MakeCallback (&DeviceQueueDrop));
+    Config::ConnectWithoutContext ("/NodeList/0/ApplicationList/*/$ns3::VideoStreamServer/Fairness",
+                                   MakeCallback (&ServerFairness));
+
     pointToPoint.EnablePcap ("videoStream", d0d1.Get (1), false);
     pointToPoint.EnablePcap ("videoStream", d0d2.Get (1), false);
+    ConnectFecCounters ();
+    InstallQoeCollector ();
     Simulator::Run ();
+    WriteQoe (qoeFile);
     Simulator::Destroy ();
   }
-  else if (CASE == 3)
+  else if (scenario == 3)
   {
     const uint32_t nWifi = 1, nAp = 1;
     NodeContainer wifiStaNodes;
@@ -191,10 +320,13 @@ main (int argc, char *argv[])
   
     phy.EnablePcap ("wifi-videoStream", apDevices.Get (0));
     AnimationInterface anim("wifi-1-3.xml");
+    ConnectFecCounters ();
+    InstallQoeCollector ();
     Simulator::Run ();
+    WriteQoe (qoeFile);
     Simulator::Destroy ();
   }
-  else if (CASE == 4)
+  else if (scenario == 4)
   {
     const uint32_t nWifi = 3, nAp = 3;
     NodeContainer wifiStaNodes;
@@ -276,9 +408,13 @@ main (int argc, char *argv[])
   
     phy.EnablePcap ("wifi-videoStream", apDevices.Get (0));
     AnimationInterface anim("wifi-1-3.xml");
+    ConnectFecCounters ();
+    InstallQoeCollector ();
     Simulator::Run ();
+    WriteQoe (qoeFile);
     Simulator::Destroy ();
   }
 
+  ReportFec ();
   return 0;
 }
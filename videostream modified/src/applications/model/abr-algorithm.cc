@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "abr-algorithm.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AbrAlgorithm");
+
+NS_OBJECT_ENSURE_REGISTERED (AbrAlgorithm);
+NS_OBJECT_ENSURE_REGISTERED (ThroughputAbr);
+
+TypeId
+AbrAlgorithm::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AbrAlgorithm")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+  ;
+  return tid;
+}
+
+AbrAlgorithm::AbrAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AbrAlgorithm::~AbrAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AbrAlgorithm::SetRepresentations (const std::vector<VideoStreamRepresentation> &representations)
+{
+  m_representations = representations;
+}
+
+void
+AbrAlgorithm::ReportFrame (uint32_t frameSize, Time downloadTime)
+{
+}
+
+double
+AbrAlgorithm::GetBitrate (uint32_t level) const
+{
+  return 8.0 * m_representations[level].m_frameSize * m_representations[level].m_frameRate;
+}
+
+TypeId
+ThroughputAbr::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ThroughputAbr")
+    .SetParent<AbrAlgorithm> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ThroughputAbr> ()
+    .AddAttribute ("Alpha", "Weight of a new throughput sample in the moving average",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&ThroughputAbr::m_alpha),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("SafetyFactor", "Share of the estimated throughput a level may use",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&ThroughputAbr::m_safetyFactor),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+ThroughputAbr::ThroughputAbr ()
+  : m_estimate (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ThroughputAbr::~ThroughputAbr ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ThroughputAbr::ReportFrame (uint32_t frameSize, Time downloadTime)
+{
+  NS_LOG_FUNCTION (this << frameSize << downloadTime);
+  double sample = 8.0 * frameSize / downloadTime.GetSeconds ();
+  m_estimate = m_estimate == 0 ? sample : m_alpha * sample + (1 - m_alpha) * m_estimate;
+}
+
+uint32_t
+ThroughputAbr::SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed)
+{
+  NS_LOG_FUNCTION (this << currentLevel << bufferLevel << playbackSpeed);
+  if (m_estimate == 0)
+    {
+      return currentLevel;
+    }
+  uint32_t level = 0;
+  for (uint32_t candidate = 1; candidate < m_representations.size (); candidate++)
+    {
+      if (GetBitrate (candidate) * playbackSpeed <= m_safetyFactor * m_estimate)
+        {
+          level = candidate;
+        }
+    }
+  return level;
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ABR_ALGORITHM_H
+#define ABR_ALGORITHM_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "video-stream-header.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Interface of the adaptive bitrate logic of VideoStreamClient.
+ *
+ * The client reports the download time of every frame it completes and asks
+ * for a quality level once per buffer tick. Implementations are selected by
+ * the client's AbrAlgorithm attribute.
+ */
+class AbrAlgorithm : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  AbrAlgorithm ();
+  virtual ~AbrAlgorithm ();
+
+  /**
+   * @brief Set the representations the server advertised in its manifest.
+   *
+   * @param representations the ladder, lowest level first
+   */
+  void SetRepresentations (const std::vector<VideoStreamRepresentation> &representations);
+
+  /**
+   * @brief Report that a frame has been completely received.
+   *
+   * @param frameSize the size of the frame in bytes
+   * @param downloadTime the time it took to receive the frame
+   */
+  virtual void ReportFrame (uint32_t frameSize, Time downloadTime);
+
+  /**
+   * @brief Choose the level of the next frames to request.
+   *
+   * @param currentLevel the level currently requested
+   * @param bufferLevel the playback time held in the buffer
+   * @param playbackSpeed the playback speed, 1.0 being real time
+   * @return the level to request
+   */
+  virtual uint32_t SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed) = 0;
+
+protected:
+  /**
+   * @brief Get the rate a level needs at normal playback speed.
+   *
+   * @param level the level
+   * @return the bitrate in bits per second
+   */
+  double GetBitrate (uint32_t level) const;
+
+  std::vector<VideoStreamRepresentation> m_representations;
+};
+
+/**
+ * @brief Pick the highest level whose bitrate fits an exponentially
+ * weighted moving average of the measured frame throughput.
+ */
+class ThroughputAbr : public AbrAlgorithm
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ThroughputAbr ();
+  virtual ~ThroughputAbr ();
+
+  virtual void ReportFrame (uint32_t frameSize, Time downloadTime);
+  virtual uint32_t SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed);
+
+private:
+  double m_alpha;          //!< weight of a new sample in the average
+  double m_safetyFactor;   //!< share of the estimate a level may use
+  double m_estimate;       //!< average throughput in bits per second, 0 before the first sample
+};
+
+} // namespace ns3
+
+#endif /* ABR_ALGORITHM_H */
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "bola-abr.h"
+
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BolaAbr");
+
+NS_OBJECT_ENSURE_REGISTERED (BolaAbr);
+
+TypeId
+BolaAbr::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BolaAbr")
+    .SetParent<AbrAlgorithm> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<BolaAbr> ()
+    .AddAttribute ("BufferTarget", "Buffer level at which the top level is chosen",
+                   TimeValue (Seconds (5.0)),
+                   MakeTimeAccessor (&BolaAbr::m_bufferTarget),
+                   MakeTimeChecker ())
+    .AddAttribute ("Gamma", "Weight of rebuffering avoidance against utility",
+                   DoubleValue (5.0),
+                   MakeDoubleAccessor (&BolaAbr::m_gamma),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+BolaAbr::BolaAbr ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BolaAbr::~BolaAbr ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+BolaAbr::SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed)
+{
+  NS_LOG_FUNCTION (this << currentLevel << bufferLevel << playbackSpeed);
+
+  // Decisions are taken once per second of playback, which is the segment
+  // duration of the original formulation.
+  double lowest = GetBitrate (0);
+  double topUtility = std::log (GetBitrate (m_representations.size () - 1) / lowest);
+  double v = (m_bufferTarget.GetSeconds () - 1.0) / (topUtility + m_gamma);
+  double buffer = bufferLevel.GetSeconds ();
+
+  uint32_t level = 0;
+  double best = 0;
+  for (uint32_t candidate = 0; candidate < m_representations.size (); candidate++)
+    {
+      double bitrate = GetBitrate (candidate);
+      double score = (v * (std::log (bitrate / lowest) + m_gamma) - buffer) / bitrate;
+      if (candidate == 0 || score > best)
+        {
+          level = candidate;
+          best = score;
+        }
+    }
+  return level;
+}
+
+} // namespace ns3
@@ -0,0 +1,35 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BOLA_ABR_H
+#define BOLA_ABR_H
+
+#include "abr-algorithm.h"
+
+namespace ns3 {
+
+/**
+ * @brief Buffer-based level selection with BOLA (Spiteri et al., 2016).
+ *
+ * Every level m has the utility v_m = ln (S_m / S_0), S being its bitrate.
+ * With the buffer holding Q seconds, BOLA picks the level maximizing
+ * (V (v_m + gamma) - Q) / S_m, where V is chosen so that the top level is
+ * picked once the buffer reaches the target.
+ */
+class BolaAbr : public AbrAlgorithm
+{
+public:
+  static TypeId GetTypeId (void);
+
+  BolaAbr ();
+  virtual ~BolaAbr ();
+
+  virtual uint32_t SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed);
+
+private:
+  Time m_bufferTarget;  //!< buffer level at which the top level is chosen
+  double m_gamma;       //!< weight of rebuffering avoidance against utility
+};
+
+} // namespace ns3
+
+#endif /* BOLA_ABR_H */
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "frame-reassembler.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FrameReassembler");
+
+FrameReassembler::FrameReassembler ()
+  : m_window (0),
+    m_maxFragments (0),
+    m_groupSize (1),
+    m_parity (0),
+    m_maxGroups (0),
+    m_words (0),
+    m_watermark (0),
+    m_frontier (0),
+    m_recovered (0),
+    m_discarded (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FrameReassembler::FrameReassembler (uint32_t window, uint32_t maxFragments)
+  : m_window (window),
+    m_maxFragments (maxFragments),
+    m_groupSize (1),
+    m_parity (0),
+    m_maxGroups (0),
+    m_words ((maxFragments + 63) / 64),
+    m_watermark (0),
+    m_frontier (0),
+    m_state (window),
+    m_bits (window * m_words, 0),
+    m_recovered (0),
+    m_discarded (0)
+{
+  NS_LOG_FUNCTION (this << window << maxFragments);
+}
+
+void
+FrameReassembler::SetFec (uint32_t groupSize, uint32_t parity)
+{
+  NS_LOG_FUNCTION (this << groupSize << parity);
+  m_groupSize = std::max (groupSize, 1u);
+  m_parity = parity;
+  m_maxGroups = parity == 0 ? 0 : (m_maxFragments + m_groupSize - 1) / m_groupSize;
+  m_words = (m_maxFragments + m_maxGroups * m_parity + 63) / 64;
+  m_state.assign (m_window, FrameState ());
+  m_bits.assign (m_window * m_words, 0);
+  m_groups.assign (m_window * m_maxGroups, 0);
+}
+
+void
+FrameReassembler::Restart (uint32_t watermark)
+{
+  NS_LOG_FUNCTION (this << watermark);
+  m_watermark = watermark;
+  m_frontier = watermark;
+  m_state.assign (m_window, FrameState ());
+  std::fill (m_bits.begin (), m_bits.end (), 0);
+  std::fill (m_groups.begin (), m_groups.end (), 0);
+}
+
+uint64_t *
+FrameReassembler::GetBits (uint32_t frame)
+{
+  return &m_bits[(frame % m_window) * m_words];
+}
+
+uint16_t *
+FrameReassembler::GetGroups (uint32_t frame)
+{
+  return m_groups.data () + (frame % m_window) * m_maxGroups;
+}
+
+uint32_t
+FrameReassembler::AddFragment (uint32_t frame, uint32_t fragment, uint32_t fragmentCount)
+{
+  NS_LOG_FUNCTION (this << frame << fragment << fragmentCount);
+
+  uint32_t groupCount = m_parity == 0 ? 0 : (fragmentCount + m_groupSize - 1) / m_groupSize;
+  if (frame < m_watermark || frame - m_watermark >= m_window
+      || fragment >= fragmentCount + groupCount * m_parity || fragmentCount > m_maxFragments)
+    {
+      m_discarded++;
+      return 0;
+    }
+
+  FrameState &state = m_state[frame % m_window];
+  uint64_t *bits = GetBits (frame);
+  uint16_t *groups = GetGroups (frame);
+  if (state.m_expected != fragmentCount)
+    {
+      // The frame is (re)sent at another level: what arrived so far is stale.
+      std::fill (bits, bits + m_words, 0);
+      std::fill (groups, groups + m_maxGroups, 0);
+      state.m_received = 0;
+      state.m_expected = fragmentCount;
+    }
+
+  uint64_t mask = uint64_t (1) << (fragment % 64);
+  if (bits[fragment / 64] & mask)
+    {
+      m_discarded++;
+      return 0;
+    }
+  bits[fragment / 64] |= mask;
+  if (fragment < fragmentCount)
+    {
+      state.m_received++;
+    }
+  m_frontier = std::max (m_frontier, frame + 1);
+
+  if (m_parity != 0)
+    {
+      uint32_t group = fragment < fragmentCount ? fragment / m_groupSize
+        : (fragment - fragmentCount) / m_parity;
+      uint32_t first = group * m_groupSize;
+      uint32_t last = std::min (first + m_groupSize, fragmentCount);
+      if (groups[group] >= last - first)
+        {
+          // The group was rebuilt already, this parity came too late to help.
+          m_discarded++;
+        }
+      else if (++groups[group] == last - first)
+        {
+          // Enough fragments of the group arrived: rebuild its missing data.
+          for (uint32_t data = first; data < last; data++)
+            {
+              uint64_t dataMask = uint64_t (1) << (data % 64);
+              if (!(bits[data / 64] & dataMask))
+                {
+                  bits[data / 64] |= dataMask;
+                  state.m_received++;
+                  m_recovered++;
+                }
+            }
+        }
+    }
+
+  uint32_t advanced = 0;
+  while (IsComplete (m_watermark))
+    {
+      // Recycle the slot for the frame one window ahead.
+      uint64_t *done = GetBits (m_watermark);
+      std::fill (done, done + m_words, 0);
+      uint16_t *doneGroups = GetGroups (m_watermark);
+      std::fill (doneGroups, doneGroups + m_maxGroups, 0);
+      m_state[m_watermark % m_window] = FrameState ();
+      m_watermark++;
+      advanced++;
+    }
+  m_frontier = std::max (m_frontier, m_watermark);
+  return advanced;
+}
+
+uint32_t
+FrameReassembler::GetWatermark (void) const
+{
+  return m_watermark;
+}
+
+bool
+FrameReassembler::IsComplete (uint32_t frame) const
+{
+  if (frame < m_watermark)
+    {
+      return true;
+    }
+  if (frame - m_watermark >= m_window)
+    {
+      return false;
+    }
+  const FrameState &state = m_state[frame % m_window];
+  return state.m_expected != 0 && state.m_received == state.m_expected;
+}
+
+uint32_t
+FrameReassembler::GetFrontier (void) const
+{
+  return m_frontier;
+}
+
+uint32_t
+FrameReassembler::GetMissingFragments (uint32_t frame, std::vector<uint8_t> &missing) const
+{
+  missing.clear ();
+  if (frame < m_watermark || frame - m_watermark >= m_window)
+    {
+      return 0;
+    }
+  const FrameState &state = m_state[frame % m_window];
+  const uint64_t *bits = &m_bits[(frame % m_window) * m_words];
+  missing.resize ((state.m_expected + 7) / 8, 0);
+  for (uint32_t fragment = 0; fragment < state.m_expected; fragment++)
+    {
+      if (!(bits[fragment / 64] & (uint64_t (1) << (fragment % 64))))
+        {
+          missing[fragment / 8] |= 1 << (fragment % 8);
+        }
+    }
+  return state.m_expected;
+}
+
+uint32_t
+FrameReassembler::GetRecoveredFragments (void) const
+{
+  return m_recovered;
+}
+
+uint32_t
+FrameReassembler::GetDiscardedFragments (void) const
+{
+  return m_discarded;
+}
+
+} // namespace ns3
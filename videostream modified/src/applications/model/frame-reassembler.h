@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef FRAME_REASSEMBLER_H
+#define FRAME_REASSEMBLER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Track which fragments of each video frame have arrived.
+ *
+ * Every frame keeps a bitset of received fragments and a received count, so
+ * a fragment is accounted for with constant work. The reassembler also keeps
+ * the contiguous-complete watermark, i.e. the first frame that is not fully
+ * received yet, and moves it forward only over frames that just completed.
+ * Duplicate fragments and fragments of frames below the watermark are
+ * ignored, and fragments may arrive in any order.
+ *
+ * The state lives in a ring of slots covering the frames from the watermark
+ * on, so memory is bounded by the reassembly window rather than by the length
+ * of the video. Fragments of frames beyond the window are discarded.
+ *
+ * With FEC, the data fragments of a frame are cut in groups, each followed by
+ * parity fragments numbered after the last data fragment. The code is taken
+ * to be MDS (XOR for one parity fragment, Reed-Solomon for more), so any
+ * group is recovered as soon as as many of its fragments arrived as it has
+ * data fragments, whichever they are.
+ */
+class FrameReassembler
+{
+public:
+  FrameReassembler ();
+
+  /**
+   * @brief Construct a new FrameReassembler object.
+   *
+   * @param window the number of frames past the watermark that can be tracked
+   * @param maxFragments the largest fragment count of a single frame
+   */
+  FrameReassembler (uint32_t window, uint32_t maxFragments);
+
+  /**
+   * @brief Set the FEC layout of the frames. Must be called before the first
+   * fragment arrives.
+   *
+   * @param groupSize the data fragments per group
+   * @param parity the parity fragments per group, 0 without FEC
+   */
+  void SetFec (uint32_t groupSize, uint32_t parity);
+
+  /**
+   * @brief Forget every frame and start over at a frame, e.g. when joining a
+   * live stream in the middle.
+   *
+   * @param watermark the first frame expected
+   */
+  void Restart (uint32_t watermark);
+
+  /**
+   * @brief Record the arrival of a fragment.
+   *
+   * @param frame the frame number of the fragment
+   * @param fragment the index of the fragment inside the frame, parity included
+   * @param fragmentCount the number of data fragments the frame is split into
+   * @return the number of frames the watermark moved over
+   */
+  uint32_t AddFragment (uint32_t frame, uint32_t fragment, uint32_t fragmentCount);
+
+  /**
+   * @brief Get the first frame that has not been completely received.
+   *
+   * @return the contiguous-complete watermark
+   */
+  uint32_t GetWatermark (void) const;
+
+  /**
+   * @brief Check whether all fragments of a frame have arrived.
+   *
+   * @param frame the frame number
+   * @return true if the frame is complete
+   */
+  bool IsComplete (uint32_t frame) const;
+
+  /**
+   * @brief Get one past the highest frame a fragment was received for.
+   *
+   * @return the receive frontier, never below the watermark
+   */
+  uint32_t GetFrontier (void) const;
+
+  /**
+   * @brief List the fragments of a frame that have not arrived.
+   *
+   * @param frame the frame number, at or above the watermark and inside the window
+   * @param missing filled with one bit per fragment, set if it is missing,
+   *        lowest bit first; left empty if no fragment of the frame arrived
+   * @return the fragment count of the frame, 0 if no fragment arrived
+   */
+  uint32_t GetMissingFragments (uint32_t frame, std::vector<uint8_t> &missing) const;
+
+  /**
+   * @brief Get the number of data fragments rebuilt from parity so far.
+   *
+   * @return the recovered fragment count
+   */
+  uint32_t GetRecoveredFragments (void) const;
+
+  /**
+   * @brief Get the number of fragments that brought nothing new so far:
+   * duplicates, fragments of frames outside the window, and parity of groups
+   * that were already complete.
+   *
+   * @return the discarded fragment count
+   */
+  uint32_t GetDiscardedFragments (void) const;
+
+private:
+  struct FrameState
+  {
+    uint32_t m_received;  //!< distinct fragments received so far
+    uint32_t m_expected;  //!< fragment count announced by the server, 0 if unknown
+  };
+
+  uint64_t *GetBits (uint32_t frame);
+
+  uint16_t *GetGroups (uint32_t frame);
+
+  uint32_t m_window;
+  uint32_t m_maxFragments;
+  uint32_t m_groupSize;
+  uint32_t m_parity;
+  uint32_t m_maxGroups;             //!< FEC groups of the largest frame, 0 without FEC
+  uint32_t m_words;                 //!< 64-bit words in the bitset of one slot
+  uint32_t m_watermark;
+  uint32_t m_frontier;
+  std::vector<FrameState> m_state;  //!< frame f lives in slot f % m_window
+  std::vector<uint64_t> m_bits;     //!< m_words words per slot, back to back
+  std::vector<uint16_t> m_groups;   //!< fragments received per group, m_maxGroups per slot
+  uint32_t m_recovered;
+  uint32_t m_discarded;
+};
+
+} // namespace ns3
+
+#endif /* FRAME_REASSEMBLER_H */
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "gcc-rate-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("GccRateController");
+
+NS_OBJECT_ENSURE_REGISTERED (GccRateController);
+
+// Gains of the adaptive threshold, per millisecond, from the GCC draft: the
+// threshold rises quickly towards gradients above it and decays slowly
+// towards those below. The draft caps the elapsed time of one update.
+static const double THRESHOLD_GAIN_UP = 0.01;
+static const double THRESHOLD_GAIN_DOWN = 0.00018;
+static const double MIN_THRESHOLD = 6.0;
+static const double MAX_THRESHOLD = 600.0;
+static const double MAX_THRESHOLD_ELAPSED = 100.0;
+// The loss-based controller grows by LOSS_INCREASE every LOSS_INTERVAL
+// milliseconds while the loss is low, whatever the report interval.
+static const double LOSS_INCREASE = 1.05;
+static const double LOSS_INTERVAL = 100.0;
+// Neither controller may go above this multiple of the received rate.
+static const double MAX_RECEIVED_RATIO = 1.5;
+
+TypeId
+GccRateController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GccRateController")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<GccRateController> ()
+    .AddAttribute ("InitialRate", "Send rate before the first receiver report",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&GccRateController::m_initialRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("MinRate", "Lowest send rate",
+                   DataRateValue (DataRate ("100kbps")),
+                   MakeDataRateAccessor (&GccRateController::m_minRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("MaxRate", "Highest send rate",
+                   DataRateValue (DataRate ("100Mbps")),
+                   MakeDataRateAccessor (&GccRateController::m_maxRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Beta", "Share of the received rate kept when the path is overused",
+                   DoubleValue (0.85),
+                   MakeDoubleAccessor (&GccRateController::m_beta),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("IncreaseFactor", "Growth of the rate per second while the path is not congested",
+                   DoubleValue (1.08),
+                   MakeDoubleAccessor (&GccRateController::m_increaseFactor),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("InitialThreshold", "Initial delay gradient above which the path is overused",
+                   TimeValue (MicroSeconds (12500)),
+                   MakeTimeAccessor (&GccRateController::m_initialThreshold),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+GccRateController::GccRateController ()
+  : m_state (INCREASE),
+    m_delayRate (0),
+    m_lossRate (0),
+    m_threshold (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+GccRateController::~GccRateController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+GccRateController::NotifyConstructionCompleted (void)
+{
+  // The attributes are set by now.
+  m_delayRate = m_initialRate.GetBitRate ();
+  m_lossRate = m_initialRate.GetBitRate ();
+  m_threshold = m_initialThreshold.GetSeconds () * 1000;
+  Object::NotifyConstructionCompleted ();
+}
+
+DataRate
+GccRateController::GetRate (void) const
+{
+  double rate = std::min (m_delayRate, m_lossRate);
+  rate = std::min (std::max (rate, (double) m_minRate.GetBitRate ()), (double) m_maxRate.GetBitRate ());
+  return DataRate (rate);
+}
+
+DataRate
+GccRateController::Update (DataRate receivedRate, double lossFraction, Time delayGradient, Time interval, Time rtt)
+{
+  NS_LOG_FUNCTION (this << receivedRate << lossFraction << delayGradient << interval << rtt);
+  double gradient = delayGradient.GetSeconds () * 1000;
+  double elapsed = interval.GetSeconds () * 1000;
+  double received = receivedRate.GetBitRate ();
+
+  // Overuse detector with its adaptive threshold.
+  double gain = std::fabs (gradient) < m_threshold ? THRESHOLD_GAIN_DOWN : THRESHOLD_GAIN_UP;
+  m_threshold += std::min (elapsed, MAX_THRESHOLD_ELAPSED) * gain * (std::fabs (gradient) - m_threshold);
+  m_threshold = std::min (std::max (m_threshold, MIN_THRESHOLD), MAX_THRESHOLD);
+  if (gradient > m_threshold)
+    {
+      m_state = DECREASE;
+    }
+  else if (gradient < -m_threshold)
+    {
+      m_state = HOLD;
+    }
+  else if (m_state == DECREASE)
+    {
+      m_state = HOLD;
+    }
+  else
+    {
+      m_state = INCREASE;
+    }
+
+  switch (m_state)
+    {
+    case INCREASE:
+      m_delayRate *= std::pow (m_increaseFactor, interval.GetSeconds ());
+      break;
+    case DECREASE:
+      // The reports of the round trip after a decrease still show the queue
+      // built before it. Without a received rate to go by, the controller
+      // backs off from the rate it sends at.
+      if (Simulator::Now () - m_lastDecrease >= rtt)
+        {
+          double current = GetRate ().GetBitRate ();
+          m_delayRate = m_beta * (received > 0 ? std::min (received, current) : current);
+          m_lastDecrease = Simulator::Now ();
+        }
+      break;
+    case HOLD:
+      break;
+    }
+
+  if (lossFraction > 0.1)
+    {
+      m_lossRate *= 1 - 0.5 * lossFraction;
+    }
+  else if (lossFraction < 0.02)
+    {
+      m_lossRate *= std::pow (LOSS_INCREASE, elapsed / LOSS_INTERVAL);
+    }
+
+  // Neither part may run away from the rate actually used.
+  double maxRate = m_maxRate.GetBitRate ();
+  if (received > 0)
+    {
+      m_delayRate = std::min (m_delayRate, MAX_RECEIVED_RATIO * received);
+      m_lossRate = std::min (m_lossRate, MAX_RECEIVED_RATIO * received);
+    }
+  double minRate = m_minRate.GetBitRate ();
+  m_delayRate = std::min (std::max (m_delayRate, minRate), maxRate);
+  m_lossRate = std::min (std::max (m_lossRate, minRate), maxRate);
+  NS_LOG_INFO ("Gradient " << gradient << "ms, threshold " << m_threshold << "ms, loss " << lossFraction
+               << ": send rate " << GetRate ());
+  return GetRate ();
+}
+
+} // namespace ns3
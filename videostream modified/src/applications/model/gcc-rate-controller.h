@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef GCC_RATE_CONTROLLER_H
+#define GCC_RATE_CONTROLLER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+/**
+ * @brief Choose the send rate of a VideoStreamServer session from the
+ * receiver reports of its client, after Google Congestion Control.
+ *
+ * The delay-based part compares the one-way delay gradient with an adaptive
+ * threshold: above it the path is overused and the rate drops to Beta times
+ * the received rate, at most once per round-trip time; below its opposite
+ * the queues drain and the rate holds; in between the rate grows by
+ * IncreaseFactor per second, up to 1.5 times the received rate. The
+ * loss-based part cuts the rate in proportion to the losses above 10% and
+ * raises it by 5% below 2%. The send rate is the lower of both, between
+ * MinRate and MaxRate.
+ */
+class GccRateController : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  GccRateController ();
+  virtual ~GccRateController ();
+
+  /**
+   * @brief Get the send rate chosen so far, InitialRate before any report.
+   *
+   * @return the send rate
+   */
+  DataRate GetRate (void) const;
+
+  /**
+   * @brief Update the send rate from a receiver report.
+   *
+   * @param receivedRate the rate the client received at over the interval
+   * @param lossFraction the share of the fragments lost over the interval
+   * @param delayGradient the change of the one-way delay since the previous
+   *        interval
+   * @param interval the time covered by the report
+   * @param rtt the round-trip time, zero if unknown
+   * @return the new send rate
+   */
+  DataRate Update (DataRate receivedRate, double lossFraction, Time delayGradient, Time interval, Time rtt);
+
+protected:
+  virtual void NotifyConstructionCompleted (void);
+
+private:
+  enum State
+  {
+    HOLD,
+    INCREASE,
+    DECREASE
+  };
+
+  DataRate m_initialRate;   //!< rate before the first report
+  DataRate m_minRate;       //!< lowest send rate
+  DataRate m_maxRate;       //!< highest send rate
+  double m_beta;            //!< share of the received rate kept on overuse
+  double m_increaseFactor;  //!< rate growth per second without congestion
+  Time m_initialThreshold;  //!< initial overuse threshold of the delay gradient
+
+  State m_state;
+  double m_delayRate;       //!< rate of the delay-based controller, in bit/s
+  double m_lossRate;        //!< rate of the loss-based controller, in bit/s
+  double m_threshold;       //!< adaptive overuse threshold, in milliseconds
+  Time m_lastDecrease;
+};
+
+} // namespace ns3
+
+#endif /* GCC_RATE_CONTROLLER_H */
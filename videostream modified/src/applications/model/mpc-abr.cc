@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "mpc-abr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpcAbr");
+
+NS_OBJECT_ENSURE_REGISTERED (MpcAbr);
+
+TypeId
+MpcAbr::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpcAbr")
+    .SetParent<AbrAlgorithm> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<MpcAbr> ()
+    .AddAttribute ("Horizon", "Number of one-second steps looked ahead",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&MpcAbr::m_horizon),
+                   MakeUintegerChecker<uint32_t> (1, 8))
+    .AddAttribute ("Samples", "Number of frame throughput samples in the harmonic mean",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&MpcAbr::m_samples),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SwitchPenalty", "QoE cost of a level switch, per Mbps of bitrate difference",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MpcAbr::m_switchPenalty),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("RebufferPenalty", "QoE cost of one second of rebuffering, in Mbps",
+                   DoubleValue (20.0),
+                   MakeDoubleAccessor (&MpcAbr::m_rebufferPenalty),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+MpcAbr::MpcAbr ()
+  : m_lastPrediction (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpcAbr::~MpcAbr ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MpcAbr::ReportFrame (uint32_t frameSize, Time downloadTime)
+{
+  NS_LOG_FUNCTION (this << frameSize << downloadTime);
+  double sample = 8.0 * frameSize / downloadTime.GetSeconds ();
+  if (m_lastPrediction > 0)
+    {
+      m_errors.push_back (std::fabs (m_lastPrediction - sample) / sample);
+      if (m_errors.size () > m_samples)
+        {
+          m_errors.pop_front ();
+        }
+    }
+  m_throughput.push_back (sample);
+  if (m_throughput.size () > m_samples)
+    {
+      m_throughput.pop_front ();
+    }
+}
+
+double
+MpcAbr::StepQoe (uint32_t level, uint32_t previousLevel, double &buffer,
+                 double throughput, double playbackSpeed) const
+{
+  // One step is one second of playback, i.e. bitrate * speed bits.
+  double bits = GetBitrate (level) * playbackSpeed;
+  double download = bits / throughput;
+  double rebuffer = std::max (download - buffer, 0.0);
+  buffer = std::max (buffer - download, 0.0) + 1.0;
+  return bits / 1e6
+         - m_switchPenalty * std::fabs (GetBitrate (level) - GetBitrate (previousLevel)) / 1e6
+         - m_rebufferPenalty * rebuffer;
+}
+
+double
+MpcAbr::Search (uint32_t step, uint32_t previousLevel, double buffer,
+                double throughput, double playbackSpeed) const
+{
+  if (step == m_horizon)
+    {
+      return 0;
+    }
+  double best = -std::numeric_limits<double>::infinity ();
+  for (uint32_t level = 0; level < m_representations.size (); level++)
+    {
+      double next = buffer;
+      double qoe = StepQoe (level, previousLevel, next, throughput, playbackSpeed);
+      best = std::max (best, qoe + Search (step + 1, level, next, throughput, playbackSpeed));
+    }
+  return best;
+}
+
+uint32_t
+MpcAbr::SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed)
+{
+  NS_LOG_FUNCTION (this << currentLevel << bufferLevel << playbackSpeed);
+  if (m_throughput.empty ())
+    {
+      return currentLevel;
+    }
+
+  double inverse = 0;
+  for (std::deque<double>::const_iterator it = m_throughput.begin (); it != m_throughput.end (); it++)
+    {
+      inverse += 1 / *it;
+    }
+  double harmonic = m_throughput.size () / inverse;
+  double maxError = m_errors.empty () ? 0 : *std::max_element (m_errors.begin (), m_errors.end ());
+  double throughput = harmonic / (1 + maxError);
+  m_lastPrediction = harmonic;
+
+  uint32_t level = currentLevel;
+  double best = -std::numeric_limits<double>::infinity ();
+  for (uint32_t candidate = 0; candidate < m_representations.size (); candidate++)
+    {
+      double next = bufferLevel.GetSeconds ();
+      double qoe = StepQoe (candidate, currentLevel, next, throughput, playbackSpeed);
+      qoe += Search (1, candidate, next, throughput, playbackSpeed);
+      if (qoe > best)
+        {
+          level = candidate;
+          best = qoe;
+        }
+    }
+  return level;
+}
+
+} // namespace ns3
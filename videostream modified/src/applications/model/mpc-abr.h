@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef MPC_ABR_H
+#define MPC_ABR_H
+
+#include "abr-algorithm.h"
+
+#include <deque>
+
+namespace ns3 {
+
+/**
+ * @brief Robust model predictive control (Yin et al., 2015).
+ *
+ * The throughput is predicted as the harmonic mean of the last frame
+ * samples, discounted by the largest relative error of past predictions.
+ * Every level sequence over the horizon, one step per second of playback, is
+ * then simulated against that prediction, and the first level of the
+ * sequence with the best QoE (bitrate, minus switch and rebuffer penalties)
+ * is chosen. The search visits levels^Horizon sequences.
+ */
+class MpcAbr : public AbrAlgorithm
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpcAbr ();
+  virtual ~MpcAbr ();
+
+  virtual void ReportFrame (uint32_t frameSize, Time downloadTime);
+  virtual uint32_t SelectLevel (uint32_t currentLevel, Time bufferLevel, double playbackSpeed);
+
+private:
+  /**
+   * @brief QoE of downloading one step at a level.
+   *
+   * @param level the level of the step
+   * @param previousLevel the level of the previous step
+   * @param buffer the buffer level in seconds, updated to the level after the step
+   * @param throughput the predicted throughput in bits per second
+   * @param playbackSpeed the playback speed
+   * @return the QoE of the step
+   */
+  double StepQoe (uint32_t level, uint32_t previousLevel, double &buffer,
+                  double throughput, double playbackSpeed) const;
+
+  /**
+   * @brief Best QoE reachable from a state, searching the remaining steps.
+   *
+   * @param step the index of the step to decide
+   * @param previousLevel the level of the previous step
+   * @param buffer the buffer level in seconds before the step
+   * @param throughput the predicted throughput in bits per second
+   * @param playbackSpeed the playback speed
+   * @return the QoE of the best sequence of the remaining steps
+   */
+  double Search (uint32_t step, uint32_t previousLevel, double buffer,
+                 double throughput, double playbackSpeed) const;
+
+  uint32_t m_horizon;              //!< number of steps looked ahead
+  uint32_t m_samples;              //!< throughput samples in the harmonic mean
+  double m_switchPenalty;          //!< QoE cost of a switch, per Mbps of difference
+  double m_rebufferPenalty;        //!< QoE cost of a second of rebuffering, in Mbps
+  std::deque<double> m_throughput; //!< last frame throughputs in bits per second
+  std::deque<double> m_errors;     //!< relative errors of the last predictions
+  double m_lastPrediction;         //!< prediction made at the last decision, 0 if none
+};
+
+} // namespace ns3
+
+#endif /* MPC_ABR_H */
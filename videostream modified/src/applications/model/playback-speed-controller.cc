@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "playback-speed-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PlaybackSpeedController");
+
+NS_OBJECT_ENSURE_REGISTERED (PlaybackSpeedController);
+
+TypeId
+PlaybackSpeedController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PlaybackSpeedController")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<PlaybackSpeedController> ()
+    .AddAttribute ("MinSpeed", "Lowest playback speed, reached when the buffer is empty",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&PlaybackSpeedController::m_minSpeed),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("MaxSpeed", "Highest playback speed, approached when far behind the live edge",
+                   DoubleValue (2.5),
+                   MakeDoubleAccessor (&PlaybackSpeedController::m_maxSpeed),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("SafeBuffer", "Buffer level below which playback slows down",
+                   TimeValue (Seconds (2.0)),
+                   MakeTimeAccessor (&PlaybackSpeedController::m_safeBuffer),
+                   MakeTimeChecker ())
+    .AddAttribute ("TargetLatency", "Distance to the live edge above which playback speeds up",
+                   TimeValue (Seconds (3.0)),
+                   MakeTimeAccessor (&PlaybackSpeedController::m_targetLatency),
+                   MakeTimeChecker ())
+    .AddAttribute ("CatchUpRate", "Steepness of the catch up, per second of latency above the target",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&PlaybackSpeedController::m_catchUpRate),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+PlaybackSpeedController::PlaybackSpeedController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PlaybackSpeedController::~PlaybackSpeedController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+double
+PlaybackSpeedController::SelectSpeed (double nominalSpeed, Time bufferLevel, Time latency) const
+{
+  NS_LOG_FUNCTION (this << nominalSpeed << bufferLevel << latency);
+  double nominal = std::min (std::max (nominalSpeed, m_minSpeed), m_maxSpeed);
+  double speed = nominal;
+
+  if (!latency.IsNegative () && latency > m_targetLatency)
+    {
+      // tanh keeps the speed below MaxSpeed and smooth around the target.
+      double excess = (latency - m_targetLatency).GetSeconds ();
+      speed = nominal + (m_maxSpeed - nominal) * std::tanh (m_catchUpRate * excess);
+    }
+
+  if (bufferLevel < m_safeBuffer)
+    {
+      double fill = m_safeBuffer.IsStrictlyPositive () ? bufferLevel.GetSeconds () / m_safeBuffer.GetSeconds () : 1;
+      speed = std::min (speed, m_minSpeed + (nominal - m_minSpeed) * fill);
+    }
+
+  return std::min (std::max (speed, m_minSpeed), m_maxSpeed);
+}
+
+} // namespace ns3
@@ -0,0 +1,52 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef PLAYBACK_SPEED_CONTROLLER_H
+#define PLAYBACK_SPEED_CONTROLLER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * @brief Adjust the playback speed of VideoStreamClient from its buffer level
+ * and its distance to the live edge.
+ *
+ * The speed stays at the nominal speed chosen by the user unless the client
+ * lags the live edge by more than the target latency, in which case it
+ * rises towards MaxSpeed with the excess latency, or the buffer holds less
+ * than SafeBuffer, in which case it falls linearly towards MinSpeed to delay
+ * the stall. Slowing down wins over catching up. The ABR algorithm is given
+ * the resulting speed, so faster playback asks for a lower level rather than
+ * draining the buffer.
+ */
+class PlaybackSpeedController : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  PlaybackSpeedController ();
+  virtual ~PlaybackSpeedController ();
+
+  /**
+   * @brief Choose the playback speed until the next decision.
+   *
+   * @param nominalSpeed the speed chosen by the user
+   * @param bufferLevel the playback time held in the buffer
+   * @param latency the distance to the live edge, negative if the stream is
+   *        not live
+   * @return the speed, between MinSpeed and MaxSpeed
+   */
+  double SelectSpeed (double nominalSpeed, Time bufferLevel, Time latency) const;
+
+private:
+  double m_minSpeed;     //!< lowest speed
+  double m_maxSpeed;     //!< highest speed
+  Time m_safeBuffer;     //!< buffer level below which playback slows down
+  Time m_targetLatency;  //!< distance to the live edge that is caught up
+  double m_catchUpRate;  //!< steepness of the catch up, per second of excess latency
+};
+
+} // namespace ns3
+
+#endif /* PLAYBACK_SPEED_CONTROLLER_H */
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "video-frame-trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VideoFrameTrace");
+
+Ptr<const VideoFrameTrace>
+VideoFrameTrace::Get (std::string fileName, uint32_t fragmentPayload, uint32_t fecGroupSize)
+{
+  NS_LOG_FUNCTION (fileName << fragmentPayload << fecGroupSize);
+
+  typedef std::pair<std::string, std::pair<uint32_t, uint32_t> > Key;
+  static std::map<Key, Ptr<const VideoFrameTrace> > cache;
+  Key key (fileName, std::make_pair (fragmentPayload, fecGroupSize));
+  std::map<Key, Ptr<const VideoFrameTrace> >::iterator it = cache.find (key);
+  if (it == cache.end ())
+    {
+      Ptr<const VideoFrameTrace> trace (new VideoFrameTrace (fileName, fragmentPayload, fecGroupSize), false);
+      it = cache.insert (std::make_pair (key, trace)).first;
+    }
+  return it->second;
+}
+
+VideoFrameTrace::VideoFrameTrace (std::string fileName, uint32_t fragmentPayload, uint32_t fecGroupSize)
+  : m_frames (0),
+    m_levels (0),
+    m_fragmentPayload (fragmentPayload),
+    m_fecGroupSize (fecGroupSize),
+    m_maxFragments (0)
+{
+  NS_LOG_FUNCTION (this << fileName << fragmentPayload << fecGroupSize);
+
+  std::ifstream file (fileName.c_str ());
+  if (!file.is_open ())
+    {
+      NS_FATAL_ERROR ("Error: Failed to open frame file " << fileName);
+    }
+
+  std::string line;
+  std::vector<uint32_t> row;
+  while (std::getline (file, line))
+    {
+      row.clear ();
+      const char *cursor = line.c_str ();
+      while (true)
+        {
+          char *end;
+          unsigned long size = std::strtoul (cursor, &end, 10);
+          if (end == cursor)
+            {
+              break;
+            }
+          row.push_back (size);
+          cursor = end;
+        }
+      if (row.empty ())
+        {
+          continue;
+        }
+      if (m_levels == 0)
+        {
+          m_levels = row.size ();
+        }
+      NS_ABORT_MSG_IF (row.size () != m_levels, "Frame " << m_frames << " of " << fileName
+                       << " has " << row.size () << " levels instead of " << m_levels);
+      m_sizes.insert (m_sizes.end (), row.begin (), row.end ());
+      m_frames++;
+    }
+  NS_ABORT_MSG_IF (m_frames == 0, "Frame file " << fileName << " holds no frames");
+
+  m_fragmentOffsets.resize (m_levels * (m_frames + 1));
+  for (uint32_t level = 0; level < m_levels; level++)
+    {
+      uint64_t *offsets = &m_fragmentOffsets[level * (m_frames + 1)];
+      offsets[0] = 0;
+      for (uint32_t frame = 0; frame < m_frames; frame++)
+        {
+          offsets[frame + 1] = offsets[frame] + GetFragmentCount (level, frame);
+          m_maxFragments = std::max (m_maxFragments, GetFragmentCount (level, frame));
+        }
+    }
+  if (m_fecGroupSize != 0)
+    {
+      m_groupOffsets.resize (m_levels * (m_frames + 1));
+      for (uint32_t level = 0; level < m_levels; level++)
+        {
+          uint64_t *offsets = &m_groupOffsets[level * (m_frames + 1)];
+          offsets[0] = 0;
+          for (uint32_t frame = 0; frame < m_frames; frame++)
+            {
+              offsets[frame + 1] = offsets[frame]
+                + (GetFragmentCount (level, frame) + m_fecGroupSize - 1) / m_fecGroupSize;
+            }
+        }
+    }
+  NS_LOG_INFO ("Loaded " << m_frames << " frames at " << m_levels << " levels from " << fileName);
+}
+
+uint32_t
+VideoFrameTrace::ClampLevel (uint32_t level) const
+{
+  return std::min (level, m_levels - 1);
+}
+
+uint32_t
+VideoFrameTrace::GetFrameCount (void) const
+{
+  return m_frames;
+}
+
+uint32_t
+VideoFrameTrace::GetLevelCount (void) const
+{
+  return m_levels;
+}
+
+uint32_t
+VideoFrameTrace::GetFrameSize (uint32_t level, uint32_t frame) const
+{
+  return m_sizes[frame * m_levels + ClampLevel (level)];
+}
+
+uint32_t
+VideoFrameTrace::GetFragmentCount (uint32_t level, uint32_t frame) const
+{
+  uint32_t size = GetFrameSize (level, frame);
+  return std::max ((size + m_fragmentPayload - 1) / m_fragmentPayload, 1u);
+}
+
+uint32_t
+VideoFrameTrace::GetMaxFragmentCount (void) const
+{
+  return m_maxFragments;
+}
+
+uint64_t
+VideoFrameTrace::GetFragmentOffset (uint32_t level, uint32_t frame) const
+{
+  return m_fragmentOffsets[ClampLevel (level) * (m_frames + 1) + frame];
+}
+
+uint64_t
+VideoFrameTrace::GetGroupOffset (uint32_t level, uint32_t frame) const
+{
+  if (m_groupOffsets.empty ())
+    {
+      return 0;
+    }
+  return m_groupOffsets[ClampLevel (level) * (m_frames + 1) + frame];
+}
+
+double
+VideoFrameTrace::GetAverageFrameSize (uint32_t level) const
+{
+  uint64_t total = 0;
+  for (uint32_t frame = 0; frame < m_frames; frame++)
+    {
+      total += GetFrameSize (level, frame);
+    }
+  return double (total) / m_frames;
+}
+
+} // namespace ns3
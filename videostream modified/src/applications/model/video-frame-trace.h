@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef VIDEO_FRAME_TRACE_H
+#define VIDEO_FRAME_TRACE_H
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Read-only table of per-frame, per-level frame sizes.
+ *
+ * The trace file holds one line per frame with the size in bytes of that
+ * frame at every quality level, separated by white space. Empty lines and
+ * lines starting with '#' are skipped. A level past the last column uses the
+ * last column.
+ *
+ * Besides the sizes, the table keeps for every level the prefix sums of the
+ * fragment counts and of the FEC group counts, so the number of fragments in
+ * any range of frames is known in constant time. Tables are cached by file
+ * name, fragment payload and FEC group size, so every server streaming the
+ * same content shares one copy.
+ */
+class VideoFrameTrace : public SimpleRefCount<VideoFrameTrace>
+{
+public:
+  /**
+   * @brief Get the table of a trace file, loading it on first use.
+   *
+   * @param fileName the trace file
+   * @param fragmentPayload the largest payload of a fragment, in bytes
+   * @param fecGroupSize the data fragments per FEC group, 0 without FEC
+   * @return the shared table
+   */
+  static Ptr<const VideoFrameTrace> Get (std::string fileName, uint32_t fragmentPayload,
+                                         uint32_t fecGroupSize = 0);
+
+  uint32_t GetFrameCount (void) const;
+
+  uint32_t GetLevelCount (void) const;
+
+  /**
+   * @brief Get the size of a frame.
+   *
+   * @param level the quality level
+   * @param frame the frame number
+   * @return the frame size in bytes
+   */
+  uint32_t GetFrameSize (uint32_t level, uint32_t frame) const;
+
+  /**
+   * @brief Get the number of fragments a frame is split into.
+   *
+   * @param level the quality level
+   * @param frame the frame number
+   * @return the fragment count
+   */
+  uint32_t GetFragmentCount (uint32_t level, uint32_t frame) const;
+
+  /**
+   * @brief Get the largest number of fragments a frame of any level is
+   * split into.
+   *
+   * @return the largest fragment count
+   */
+  uint32_t GetMaxFragmentCount (void) const;
+
+  /**
+   * @brief Get the number of fragments in all frames before a frame.
+   *
+   * @param level the quality level
+   * @param frame the frame number, up to GetFrameCount ()
+   * @return the fragment offset of the frame
+   */
+  uint64_t GetFragmentOffset (uint32_t level, uint32_t frame) const;
+
+  /**
+   * @brief Get the number of FEC groups in all frames before a frame.
+   *
+   * @param level the quality level
+   * @param frame the frame number, up to GetFrameCount ()
+   * @return the FEC group offset of the frame, 0 without FEC
+   */
+  uint64_t GetGroupOffset (uint32_t level, uint32_t frame) const;
+
+  /**
+   * @brief Get the mean frame size of a level.
+   *
+   * @param level the quality level
+   * @return the mean frame size in bytes
+   */
+  double GetAverageFrameSize (uint32_t level) const;
+
+private:
+  VideoFrameTrace (std::string fileName, uint32_t fragmentPayload, uint32_t fecGroupSize);
+
+  uint32_t ClampLevel (uint32_t level) const;
+
+  uint32_t m_frames;
+  uint32_t m_levels;
+  uint32_t m_fragmentPayload;
+  uint32_t m_fecGroupSize;
+  uint32_t m_maxFragments;
+  std::vector<uint32_t> m_sizes;            //!< m_levels sizes per frame, frame after frame
+  std::vector<uint64_t> m_fragmentOffsets;  //!< m_frames + 1 prefix sums per level
+  std::vector<uint64_t> m_groupOffsets;     //!< same layout, empty without FEC
+};
+
+} // namespace ns3
+
+#endif /* VIDEO_FRAME_TRACE_H */
@@ -9,9 +9,18 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/udp-socket.h"
+#include "ns3/udp-socket-factory.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/type-id.h"
+#include "ns3/object-factory.h"
 #include "video-stream-client.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace ns3
 {
   NS_LOG_COMPONENT_DEFINE("VideoStreamClientApplication");
@@ -32,7 +41,94 @@ namespace ns3
                                           UintegerValue(5000),
                                           MakeUintegerAccessor(&VideoStreamClient::m_peerPort),
                                           MakeUintegerChecker<uint16_t>())
-
+                            .AddAttribute("Protocol", "Socket factory of the transport to the server, UDP or TCP",
+                                          TypeIdValue(UdpSocketFactory::GetTypeId()),
+                                          MakeTypeIdAccessor(&VideoStreamClient::m_protocol),
+                                          MakeTypeIdChecker())
+                            .AddAttribute("ReassemblyWindow", "Number of frames past the last complete one that can be reassembled",
+                                          UintegerValue(128),
+                                          MakeUintegerAccessor(&VideoStreamClient::m_reassemblyWindow),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("MaxFragmentsPerFrame", "Fragments of a single frame the reassembly buffer holds until the manifest tells the largest fragment count of the content",
+                                          UintegerValue(256),
+                                          MakeUintegerAccessor(&VideoStreamClient::m_maxFragments),
+                                          MakeUintegerChecker<uint32_t>(1, 65535))
+                            .AddAttribute("MaxNackSize", "Largest body of a NACK in bytes, frames past it wait for the next one",
+                                          UintegerValue(1200),
+                                          MakeUintegerAccessor(&VideoStreamClient::m_maxNackSize),
+                                          MakeUintegerChecker<uint32_t>(16))
+                            .AddAttribute("Multicast", "Receive from the multicast group of the level when the server offers one, instead of requesting frames",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&VideoStreamClient::m_multicast),
+                                          MakeBooleanChecker())
+                            .AddAttribute("InitialRto", "Retransmission timeout of the control messages before the first round-trip time sample",
+                                          TimeValue(Seconds(1.0)),
+                                          MakeTimeAccessor(&VideoStreamClient::m_initialRto),
+                                          MakeTimeChecker())
+                            .AddAttribute("MinRto", "Lowest retransmission timeout of the control messages",
+                                          TimeValue(MilliSeconds(200)),
+                                          MakeTimeAccessor(&VideoStreamClient::m_minRto),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxControlRetries", "Retransmissions of a control message before it is given up",
+                                          UintegerValue(4),
+                                          MakeUintegerAccessor(&VideoStreamClient::m_maxControlRetries),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("ReportInterval", "Time between two receiver reports to the server, zero for none",
+                                          TimeValue(MilliSeconds(100)),
+                                          MakeTimeAccessor(&VideoStreamClient::m_reportInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxBuffer", "Media time the client buffers at most: the receiver reports tell the server how many frames it may still send",
+                                          TimeValue(Seconds(30.0)),
+                                          MakeTimeAccessor(&VideoStreamClient::m_maxBuffer),
+                                          MakeTimeChecker())
+                            .AddAttribute("PlaybackSpeed", "Playback speed, i.e. seconds of video played per second",
+                                          DoubleValue(1.8),
+                                          MakeDoubleAccessor(&VideoStreamClient::m_videoSpeed),
+                                          MakeDoubleChecker<double>(0.1))
+                            .AddAttribute("AdaptiveSpeed", "Let a PlaybackSpeedController move the speed around PlaybackSpeed from the buffer level and the live latency",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&VideoStreamClient::m_adaptiveSpeed),
+                                          MakeBooleanChecker())
+                            .AddAttribute("AbrAlgorithm", "Type of the adaptive bitrate algorithm choosing the video level",
+                                          TypeIdValue(ThroughputAbr::GetTypeId()),
+                                          MakeTypeIdAccessor(&VideoStreamClient::m_abrTypeId),
+                                          MakeTypeIdChecker())
+                            .AddTraceSource("Rx", "A fragment has been received",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_rxTrace),
+                                            "ns3::Packet::TracedCallback")
+                            .AddTraceSource("Discard", "A fragment brought nothing new: duplicate, outside the window or unneeded parity",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_discardTrace),
+                                            "ns3::Packet::TracedCallback")
+                            .AddTraceSource("FrameCompleted", "Every fragment of a frame has arrived, in frame order",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_frameCompletedTrace),
+                                            "ns3::VideoStreamClient::FrameCallback")
+                            .AddTraceSource("Startup", "Playback has started, after the given delay from the first manifest request",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_startupTrace),
+                                            "ns3::Time::TracedCallback")
+                            .AddTraceSource("StallStart", "Playback has stalled waiting for the given frame",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_stallStartTrace),
+                                            "ns3::VideoStreamClient::FrameCallback")
+                            .AddTraceSource("StallEnd", "Playback has resumed after a stall of the given duration",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_stallEndTrace),
+                                            "ns3::Time::TracedCallback")
+                            .AddTraceSource("LevelSwitch", "The ABR algorithm has switched the video level",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_levelSwitchTrace),
+                                            "ns3::VideoStreamClient::LevelSwitchCallback")
+                            .AddTraceSource("PlaybackProgress", "Frames have been played out of the buffer",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_playbackTrace),
+                                            "ns3::VideoStreamClient::PlaybackCallback")
+                            .AddTraceSource("FrameLatency", "A live frame has been played, with the time since its capture",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_frameLatencyTrace),
+                                            "ns3::VideoStreamClient::FrameLatencyCallback")
+                            .AddTraceSource("Speed", "Current playback speed",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_speed),
+                                            "ns3::TracedValueCallback::Double")
+                            .AddTraceSource("ControlRetransmissions", "Control messages resent after a retransmission timeout",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_controlRetransmissions),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("RecoveredFragments", "Fragments rebuilt from FEC parity",
+                                            MakeTraceSourceAccessor(&VideoStreamClient::m_recoveredFragments),
+                                            "ns3::TracedValueCallback::Uint32")
         ;
     return tid;
   }
@@ -41,35 +137,37 @@ namespace ns3
   {
     NS_LOG_FUNCTION(this);
     m_initialDelay = 1;
-    m_lastBufferSize = 0;
     m_currentBufferSize = 0;
-    m_frameSize = 0;
     m_frameRate = 5;
-    m_videoSpeed = 1.8;
-    m_stopCounter = 0;
     m_lastRecvFrame = 0;
     m_rebufferCounter = 0;
     m_videotime = 0;
+    m_totalFrames = 0;
     m_bufferEvent = EventId();
     m_sendEvent = EventId();
-    m_speedxframeRate = m_frameRate*m_videoSpeed;
-
-    m_resolutionArray[0] = 100001; //13
-    m_resolutionArray[1] = 150001; //8
-    m_resolutionArray[2] = 200001; //7
-    m_resolutionArray[3] = 230001; //6
-    m_resolutionArray[4] = 250001; //5
-    m_resolutionArray[5] = 300001; //4
-
-    m_videoLevel = 5;
-    m_resolution = m_resolutionArray[m_videoLevel];
-    for (size_t i = 0; i < TOTAL_VIDEO_FRAME; i++)
-    {
-      for (size_t j = 0; j < m_resolution/MAX_PACKET_SIZE + 1; j++)
-      {
-        m_FramePacketCounter[i][j] = false;
-      }
-    }
+    m_speedxframeRate = 0;
+
+    m_videoLevel = 0;
+    m_frameTimed = false;
+    m_recoveredFragments = 0;
+    m_multicastGroup = Ipv4Address::GetAny();
+    m_multicastPort = 0;
+    m_live = false;
+    m_stream = false;
+    m_controlSequence = 0;
+    m_controlRetransmissions = 0;
+    m_reportStarted = false;
+    m_maxSequence = 0;
+    m_reportSequence = 0;
+    m_reportFragments = 0;
+    m_reportBytes = 0;
+    m_lastMeanDelay = Seconds(-1);
+    m_receivedData = false;
+    m_playing = false;
+    m_playbackAllowed = false;
+    m_ended = false;
+    m_stalled = false;
+    m_playedFrames = 0;
   }
 
   VideoStreamClient::~VideoStreamClient()
@@ -94,6 +192,8 @@ namespace ns3
   void VideoStreamClient::DoDispose(void)
   {
     NS_LOG_FUNCTION(this);
+    m_abr = 0;
+    m_speedController = 0;
     Application::DoDispose();
   }
 
@@ -103,8 +203,7 @@ namespace ns3
 
     if (m_socket == 0)
     {
-      TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-      m_socket = Socket::CreateSocket(GetNode(), tid);
+      m_socket = Socket::CreateSocket(GetNode(), m_protocol);
       if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
       {
         if (m_socket->Bind() == -1)
@@ -142,9 +241,25 @@ namespace ns3
         NS_ASSERT_MSG(false, "Incompatible address type: " << m_peerAddress);
       }
     }
+    // A TCP connection queues what is sent before it is established.
+    m_stream = m_socket->GetSocketType() == Socket::NS3_SOCK_STREAM;
+    m_framer = VideoStreamFramer();
+    m_rto = m_initialRto;
+    m_speed = m_videoSpeed;
+    if (m_adaptiveSpeed) {
+      m_speedController = CreateObject<PlaybackSpeedController>();
+    }
+    UpdatePlaybackRate();
+    m_reassembler = FrameReassembler(m_reassemblyWindow, m_maxFragments);
+    ObjectFactory factory;
+    factory.SetTypeId(m_abrTypeId);
+    m_abr = factory.Create<AbrAlgorithm>();
     m_socket->SetRecvCallback(MakeCallback(&VideoStreamClient::HandleRead, this));
     m_sendEvent = Simulator::Schedule(MilliSeconds(1.0), &VideoStreamClient::Send, this);
     m_bufferEvent = Simulator::Schedule(Seconds(m_initialDelay), &VideoStreamClient::ReadFromBuffer, this);
+    if (m_reportInterval.IsStrictlyPositive() && !m_stream) {
+      m_reportEvent = Simulator::Schedule(m_reportInterval, &VideoStreamClient::SendReport, this);
+    }
   }
 
   void VideoStreamClient::StopApplication()
@@ -158,7 +273,18 @@ namespace ns3
       m_socket = 0;
     }
 
+    if (m_multicastSocket != 0)
+    {
+      m_multicastSocket->Close();
+      m_multicastSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+      m_multicastSocket = 0;
+    }
+
     Simulator::Cancel(m_bufferEvent);
+    Simulator::Cancel(m_playEvent);
+    Simulator::Cancel(m_reportEvent);
+    Simulator::Cancel(m_rtoEvent);
+    m_pendingControl.clear();
   }
 
   void VideoStreamClient::Send(void)
@@ -166,138 +292,564 @@ namespace ns3
     NS_LOG_FUNCTION(this);
     NS_ASSERT(m_sendEvent.IsExpired());
 
-    uint8_t send_Buffer[MAX_PACKET_SIZE];
-    sprintf((char *)send_Buffer, "res:%u lrf:%u fr:%u", m_resolution, m_lastRecvFrame, m_speedxframeRate);
+    m_requestTime = Simulator::Now();
+    SendManifestRequest();
+  }
+
+  void VideoStreamClient::SendMessage(Ptr<Packet> message)
+  {
+    m_socket->Send(m_stream ? VideoStreamFramer::Frame(message) : message);
+  }
+
+  void VideoStreamClient::SendControl(VideoStreamHeader header, Ptr<Packet> body)
+  {
+    header.SetTxTime(Simulator::Now());
+    if (m_stream) {
+      // TCP already delivers it.
+      body->AddHeader(header);
+      SendMessage(body);
+      return;
+    }
+    // A control message carries the whole state of its kind, so an older
+    // one of the same kind need not arrive any more.
+    for (std::list<PendingControl>::iterator it = m_pendingControl.begin(); it != m_pendingControl.end(); ) {
+      if (it->m_header.GetType() == header.GetType()) {
+        it = m_pendingControl.erase(it);
+      } else {
+        it++;
+      }
+    }
+    header.SetSequence(m_controlSequence++);
+    PendingControl pending;
+    pending.m_header = header;
+    pending.m_body = body;
+    pending.m_retries = 0;
+    pending.m_deadline = Simulator::Now() + m_rto;
+    m_pendingControl.push_back(pending);
+
+    Ptr<Packet> packet = body->Copy();
+    packet->AddHeader(header);
+    SendMessage(packet);
+    if (!m_rtoEvent.IsRunning()) {
+      ScheduleRto();
+    }
+  }
+
+  void VideoStreamClient::HandleControlAck(const VideoStreamHeader &header)
+  {
+    std::list<PendingControl>::iterator it = m_pendingControl.begin();
+    while (it != m_pendingControl.end() && it->m_header.GetSequence() != header.GetSequence()) {
+      it++;
+    }
+    if (it == m_pendingControl.end()) {
+      return;
+    }
+    m_pendingControl.erase(it);
+
+    // RFC 6298. The echo is the transmission time of the copy acknowledged,
+    // so resent messages give a sample as well.
+    Time rtt = Simulator::Now() - header.GetEchoTime();
+    if (m_srtt.IsZero()) {
+      m_srtt = rtt;
+      m_rttVar = Seconds(rtt.GetSeconds() / 2);
+    } else {
+      m_rttVar = Seconds(0.75 * m_rttVar.GetSeconds() + 0.25 * std::fabs((m_srtt - rtt).GetSeconds()));
+      m_srtt = Seconds(0.875 * m_srtt.GetSeconds() + 0.125 * rtt.GetSeconds());
+    }
+    m_rto = std::max(m_srtt + Seconds(4 * m_rttVar.GetSeconds()), m_minRto);
 
-    uint32_t RES;
-    uint32_t LRF;
-    uint32_t FR;
-    sscanf((char *)send_Buffer, "res:%u lrf:%u fr:%u", &RES, &LRF, &FR);
-    printf("%d, %d, %d\n", RES, LRF, FR);
+    // The messages still pending get the new timeout from now.
+    for (it = m_pendingControl.begin(); it != m_pendingControl.end(); it++) {
+      it->m_deadline = Simulator::Now() + m_rto;
+    }
+    ScheduleRto();
+  }
 
-    Ptr<Packet> firstPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-    m_socket->Send(firstPacket);
+  void VideoStreamClient::HandleReset(const VideoStreamHeader &header)
+  {
+    if (!header.GetEchoTime().IsZero()) {
+      HandleControlAck(header);
+    }
+    // The server dropped the session as idle: set it up again as it was.
+    if (m_representations.empty() || m_lastRecvFrame >= m_totalFrames) {
+      return;
+    }
+    NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client was reset by the server");
+    if (m_multicastGroup.IsAny()) {
+      SendRequest();
+    } else {
+      SendJoin();
+    }
   }
-  int flag =0;
-  uint32_t VideoStreamClient::ReadFromBuffer(void) {
-    if(flag) return(-1);
-    printf("확보중인 프레임 : %d, 버퍼링 횟수 : %d\n", m_currentBufferSize, m_rebufferCounter);
-
-    if(m_currentBufferSize < m_speedxframeRate){
-      if(m_lastRecvFrame < TOTAL_VIDEO_FRAME){
-        m_rebufferCounter++;
-        if(m_lastRecvFrame < TOTAL_VIDEO_FRAME){
-          uint8_t send_Buffer[MAX_PACKET_SIZE];
-          sprintf((char *)send_Buffer, "res:%u lrf:%u fr:%u", m_resolution, m_lastRecvFrame, m_speedxframeRate);
-          Ptr<Packet> firstPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-          m_socket->Send(firstPacket);
-        }
-        m_bufferEvent = Simulator::Schedule(Seconds(1.0), &VideoStreamClient::ReadFromBuffer, this);
-      } else{
-        printf("영상끝났음\n");
-        m_currentBufferSize = 0;
-        m_bufferEvent = Simulator::Schedule(Seconds(1.0), &VideoStreamClient::ReadFromBuffer, this);
-        flag =1;
+
+  void VideoStreamClient::HandleRto(void)
+  {
+    // Back off until an acknowledgment brings a new sample.
+    m_rto = std::min(m_rto + m_rto, Seconds(60));
+    // Every message whose timeout expired is resent, not only the oldest,
+    // so a newer one does not wait for the timeouts of the older ones.
+    for (std::list<PendingControl>::iterator it = m_pendingControl.begin(); it != m_pendingControl.end(); ) {
+      if (it->m_deadline > Simulator::Now()) {
+        it++;
+        continue;
+      }
+      if (it->m_retries >= m_maxControlRetries) {
+        // The server is unreachable for now: the next tick asks again.
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client gave up control message " << it->m_header.GetSequence());
+        it = m_pendingControl.erase(it);
+        continue;
       }
+      it->m_retries++;
+      m_controlRetransmissions++;
+      it->m_header.SetTxTime(Simulator::Now());
+      it->m_deadline = Simulator::Now() + m_rto;
+      Ptr<Packet> packet = it->m_body->Copy();
+      packet->AddHeader(it->m_header);
+      SendMessage(packet);
+      it++;
+    }
+    ScheduleRto();
+  }
 
-      if (m_rebufferCounter >= 1){
+  void VideoStreamClient::ScheduleRto(void)
+  {
+    Simulator::Cancel(m_rtoEvent);
+    if (m_pendingControl.empty()) {
+      return;
+    }
+    Time deadline = m_pendingControl.front().m_deadline;
+    for (std::list<PendingControl>::const_iterator it = m_pendingControl.begin(); it != m_pendingControl.end(); it++) {
+      deadline = Min(deadline, it->m_deadline);
+    }
+    m_rtoEvent = Simulator::Schedule(Max(deadline - Simulator::Now(), Seconds(0)), &VideoStreamClient::HandleRto, this);
+  }
 
-          if (m_videoLevel > 0){
-            m_videoLevel--;
-             printf("1. videoLevel: %d to %d  \n",m_videoLevel+1, m_videoLevel);
+  void VideoStreamClient::SendManifestRequest(void)
+  {
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::MANIFEST_REQUEST);
+    header.SetTxTime(Simulator::Now());
 
-            m_resolution = m_resolutionArray[m_videoLevel];
-            uint8_t send_Buffer[MAX_PACKET_SIZE];
-            sprintf((char *) send_Buffer, "%hu", m_resolution);
-            Ptr<Packet> levelPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-            m_socket->Send(levelPacket);
-          }
+    SendControl(header, Create<Packet>());
+  }
+
+  void VideoStreamClient::SendRequest(void)
+  {
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::REQUEST);
+    header.SetLevel(m_videoLevel);
+    header.SetFrameNumber(m_lastRecvFrame);
+    header.SetFrameRate(m_speedxframeRate);
+    header.SetTxTime(Simulator::Now());
+
+    SendControl(header, Create<Packet>());
+  }
+
+  void VideoStreamClient::SendLevelChange(void)
+  {
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::LEVEL_CHANGE);
+    header.SetLevel(m_videoLevel);
+    header.SetTxTime(Simulator::Now());
+
+    SendControl(header, Create<Packet>());
+  }
+  void VideoStreamClient::SendNack(void)
+  {
+    uint32_t watermark = m_reassembler.GetWatermark();
+    if (watermark >= m_totalFrames) {
+      return;
+    }
+
+    // Only gaps are asked for: the fragments after the highest one received
+    // may still be in flight. Once no data has arrived for about one round
+    // trip, the tail of the newest frame is asked for as well, and so is the
+    // first incomplete frame even if nothing of it arrived.
+    Time rtt = m_srtt.IsZero() ? m_rto : m_srtt;
+    bool quiet = Simulator::Now() - m_lastDataArrival > rtt;
+    VideoStreamNackHeader nack;
+    uint32_t size = nack.GetSerializedSize();
+    uint32_t frontier = m_reassembler.GetFrontier();
+    if (quiet) {
+      frontier = std::max(frontier, watermark + 1);
+    }
+    for (uint32_t frame = watermark; frame < frontier; frame++) {
+      if (m_reassembler.IsComplete(frame)) {
+        continue;
+      }
+      VideoStreamNackEntry entry;
+      entry.m_frameNumber = frame;
+      entry.m_fragmentCount = m_reassembler.GetMissingFragments(frame, entry.m_missing);
+      if (frame + 1 == frontier && !quiet) {
+        // The newest frame: what follows its highest fragment is still coming.
+        uint32_t fragment = entry.m_fragmentCount;
+        while (fragment > 0 && (entry.m_missing[(fragment - 1) / 8] & (1 << ((fragment - 1) % 8)))) {
+          fragment--;
+          entry.m_missing[fragment / 8] &= ~(1 << (fragment % 8));
+        }
+        uint8_t gaps = 0;
+        for (uint32_t i = 0; i < entry.m_missing.size(); i++) {
+          gaps |= entry.m_missing[i];
+        }
+        if (gaps == 0) {
+          continue;
         }
+      }
+      size += VideoStreamNackHeader::GetEntrySize(entry);
+      if (size > m_maxNackSize) {
+        break;
+      }
+      nack.AddFrame(entry);
+    }
 
-      NS_LOG_UNCOND("0\t" << Simulator::Now().GetSeconds() << "\t" << m_rebufferCounter);
-      NS_LOG_UNCOND("1\t" << Simulator::Now().GetSeconds() << "\t" << m_videotime);
-      NS_LOG_UNCOND("2\t" << Simulator::Now().GetSeconds() << "\t" << m_videoLevel);
-      return (-1);
-    } else {
-      m_videotime += 1;
-      printf("                                               영상 소비 %d\n", m_speedxframeRate);
-      m_currentBufferSize -= m_speedxframeRate;
-      m_rebufferCounter = 0;
-      if(m_lastRecvFrame < TOTAL_VIDEO_FRAME){
-        uint8_t send_Buffer[MAX_PACKET_SIZE];
-        sprintf((char *)send_Buffer, "res:%u lrf:%u fr:%u", m_resolution, m_lastRecvFrame, m_speedxframeRate);
-        Ptr<Packet> firstPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-        m_socket->Send(firstPacket);
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::NACK);
+    header.SetLevel(m_videoLevel);
+    header.SetFrameNumber(watermark);
+    header.SetTxTime(Simulator::Now());
+
+    Ptr<Packet> nackPacket = Create<Packet>();
+    nackPacket->AddHeader(nack);
+    SendControl(header, nackPacket);
+  }
+
+  void VideoStreamClient::SendReport(void)
+  {
+    m_reportEvent = Simulator::Schedule(m_reportInterval, &VideoStreamClient::SendReport, this);
+    // Multicast data is not sent for this client alone: nothing to report.
+    if (!m_reportStarted || !m_multicastGroup.IsAny()) {
+      return;
+    }
+
+    Time now = Simulator::Now();
+    VideoStreamReceiverReportHeader report;
+    report.SetReceived(m_reportBytes, now - m_lastReport);
+    uint32_t expected = m_maxSequence - m_reportSequence;
+    if (expected > m_reportFragments) {
+      report.SetLossFraction((double) (expected - m_reportFragments) / expected);
+    }
+    if (m_reportFragments > 0) {
+      Time meanDelay = Seconds(m_delaySum.GetSeconds() / m_reportFragments);
+      if (!m_lastMeanDelay.IsNegative()) {
+        report.SetDelayGradient(meanDelay - m_lastMeanDelay);
       }
+      m_lastMeanDelay = meanDelay;
+    }
+    report.SetHoldTime(now - m_lastDataArrival);
+    // Frames past the watermark are only tracked within the reassembly window.
+    uint32_t maxFrames = m_maxBuffer.GetSeconds() * m_frameRate;
+    uint32_t headroom = maxFrames > m_currentBufferSize ? maxFrames - m_currentBufferSize : 0;
+    report.SetHeadroom(std::min(headroom, m_reassemblyWindow));
+
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::RECEIVER_REPORT);
+    header.SetFrameNumber(m_reassembler.GetWatermark());
+    header.SetTxTime(now);
+    header.SetEchoTime(m_lastDataTx);
+
+    Ptr<Packet> reportPacket = Create<Packet>();
+    reportPacket->AddHeader(report);
+    reportPacket->AddHeader(header);
+    SendMessage(reportPacket);
+
+    m_reportSequence = m_maxSequence;
+    m_reportFragments = 0;
+    m_reportBytes = 0;
+    m_delaySum = Seconds(0);
+    m_lastReport = now;
+  }
 
-      if(m_currentBufferSize >= m_speedxframeRate){
-          if(m_videoLevel<5){
+  void VideoStreamClient::JoinGroup(void)
+  {
+    // Every level has a port of its own, so leaving the previous group is
+    // closing its socket.
+    if (m_multicastSocket != 0) {
+      m_multicastSocket->Close();
+      m_multicastSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+    Ipv4Address group(m_multicastGroup.Get() + m_videoLevel);
+    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+    m_multicastSocket = Socket::CreateSocket(GetNode(), tid);
+    if (m_multicastSocket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_multicastPort + m_videoLevel)) == -1) {
+      NS_FATAL_ERROR("Error: Failed to bind socket");
+    }
+    Ptr<UdpSocket> udpSocket = DynamicCast<UdpSocket>(m_multicastSocket);
+    if (udpSocket) {
+      udpSocket->MulticastJoinGroup(0, group);
+    }
+    m_multicastSocket->SetRecvCallback(MakeCallback(&VideoStreamClient::HandleRead, this));
+    SendJoin();
+  }
 
-            m_videoLevel++;
-            printf("2. videoLevel: %d to %d  \n",m_videoLevel-1, m_videoLevel);
+  void VideoStreamClient::SendJoin(void)
+  {
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::JOIN);
+    header.SetLevel(m_videoLevel);
+    header.SetTxTime(Simulator::Now());
 
-            m_resolution = m_resolutionArray[m_videoLevel];
-            uint8_t send_Buffer[MAX_PACKET_SIZE];
-            sprintf((char *) send_Buffer, "%hu", m_resolution);
-            Ptr<Packet> levelPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-            m_socket->Send(levelPacket);
-          }
-        }
+    SendControl(header, Create<Packet>());
+  }
+
+  void VideoStreamClient::SelectLevel(void)
+  {
+    Time bufferLevel = Seconds(m_currentBufferSize / (m_frameRate * m_speed));
+    uint32_t level = m_abr->SelectLevel(m_videoLevel, bufferLevel, m_speed);
+    if (level != m_videoLevel) {
+      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client switched from video level " << m_videoLevel << " to " << level);
+      m_levelSwitchTrace(m_videoLevel, level);
+      m_videoLevel = level;
+      if (m_multicastGroup.IsAny()) {
+        SendLevelChange();
+      } else {
+        JoinGroup();
+      }
+    }
+  }
+
+  void VideoStreamClient::UpdatePlaybackRate(void)
+  {
+    // Frames are played one by one at the exact rate, the server is asked for
+    // at least as many frames per second as are played.
+    m_frameInterval = Seconds(1.0 / (m_frameRate * m_speed));
+    m_speedxframeRate = std::ceil(m_frameRate * m_speed);
+  }
+
+  void VideoStreamClient::TryStartPlayback(void)
+  {
+    if (!m_playbackAllowed || m_ended || m_playEvent.IsRunning() || m_currentBufferSize == 0) {
+      return;
+    }
+    // Playback starts, or resumes after a stall, once a second of playback is
+    // buffered, or whatever is left of the video.
+    if (m_currentBufferSize >= m_speedxframeRate || m_lastRecvFrame >= m_totalFrames) {
+      PlayFrame();
+    }
+  }
+
+  void VideoStreamClient::PlayFrame(void)
+  {
+    if (m_currentBufferSize == 0) {
+      if (m_lastRecvFrame >= m_totalFrames) {
+        // The last frame has been played.
+        return;
+      }
+      m_stalled = true;
+      m_stallStart = Simulator::Now();
+      m_stallStartTrace(m_lastRecvFrame);
+      return;
+    }
+    if (!m_playing) {
+      m_playing = true;
+      m_startupTrace(Simulator::Now() - m_requestTime);
+    } else if (m_stalled) {
+      m_stalled = false;
+      m_stallEndTrace(Simulator::Now() - m_stallStart);
+    }
+    if (m_live) {
+      // Glass-to-glass: from the capture at the origin to the display here.
+      uint32_t frame = m_reassembler.GetWatermark() - m_currentBufferSize;
+      m_frameLatencyTrace(frame, Simulator::Now() - GetCaptureTime(frame));
+    }
+    m_currentBufferSize--;
+    m_playedFrames++;
+    const VideoStreamRepresentation &played = m_representations[m_videoLevel];
+    m_playbackTrace(Seconds((double) m_playedFrames / m_frameRate), 8.0 * played.m_frameSize * played.m_frameRate);
+    m_playEvent = Simulator::Schedule(m_frameInterval, &VideoStreamClient::PlayFrame, this);
+  }
+
+  Time VideoStreamClient::GetCaptureTime(uint32_t frame) const
+  {
+    return m_liveStart + Seconds((double) frame / m_frameRate);
+  }
+
+  Time VideoStreamClient::GetLiveLatency(void) const
+  {
+    if (!m_live) {
+      return Seconds(-1);
+    }
+    // The live edge is the frame being captured now: the latency of the
+    // playhead is the age of the next frame to play.
+    uint32_t playhead = m_reassembler.GetWatermark() - m_currentBufferSize;
+    return Simulator::Now() - GetCaptureTime(playhead);
+  }
 
-      NS_LOG_UNCOND("0\t" << Simulator::Now().GetSeconds() << "\t" << m_rebufferCounter);
-      NS_LOG_UNCOND("1\t" << Simulator::Now().GetSeconds() << "\t" << m_videotime);
-      NS_LOG_UNCOND("2\t" << Simulator::Now().GetSeconds() << "\t" << m_videoLevel);
+  void VideoStreamClient::AdjustSpeed(void)
+  {
+    if (m_speedController == 0) {
+      return;
+    }
+    Time bufferLevel = Seconds(m_currentBufferSize / (m_frameRate * m_speed));
+    double speed = m_speedController->SelectSpeed(m_videoSpeed, bufferLevel, GetLiveLatency());
+    if (speed != m_speed) {
+      m_speed = speed;
+      UpdatePlaybackRate();
+    }
+  }
 
+  uint32_t VideoStreamClient::ReadFromBuffer(void) {
+    if(m_ended) return(-1);
+    if (m_representations.empty()) {
+      // The manifest has not arrived yet: ask again.
+      SendManifestRequest();
       m_bufferEvent = Simulator::Schedule(Seconds(1.0), &VideoStreamClient::ReadFromBuffer, this);
-      return (m_currentBufferSize);
+      return (-1);
     }
+    NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client buffers " << m_currentBufferSize << " frames, rebuffering for " << m_rebufferCounter << "s");
 
+    // Frames are consumed by PlayFrame at the playback rate: once a second,
+    // only the requests, the level and the plot data are updated.
+    if (!m_playbackAllowed) {
+      m_playbackAllowed = true;
+      TryStartPlayback();
+    }
+    if (m_playEvent.IsRunning()) {
+      m_videotime += 1;
+      m_rebufferCounter = 0;
+    } else if (m_lastRecvFrame < m_totalFrames) {
+      m_rebufferCounter++;
+    } else if (m_currentBufferSize == 0) {
+      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client played the whole video");
+      m_ended = true;
+    }
+
+    if(m_lastRecvFrame < m_totalFrames){
+      // TCP delivers every fragment in order: there is nothing to NACK.
+      if (!m_stream) {
+        SendNack();
+      }
+      if (m_multicastGroup.IsAny()) {
+        SendRequest();
+      }
+    }
+
+    AdjustSpeed();
+    SelectLevel();
+
+    NS_LOG_UNCOND("0\t" << Simulator::Now().GetSeconds() << "\t" << m_rebufferCounter);
+    NS_LOG_UNCOND("1\t" << Simulator::Now().GetSeconds() << "\t" << m_videotime);
+    NS_LOG_UNCOND("2\t" << Simulator::Now().GetSeconds() << "\t" << m_videoLevel);
+
+    m_bufferEvent = Simulator::Schedule(Seconds(1.0), &VideoStreamClient::ReadFromBuffer, this);
+    return (m_currentBufferSize);
   }
   void VideoStreamClient::HandleRead(Ptr<Socket> socket) {
     NS_LOG_FUNCTION(this << socket);
 
     Ptr<Packet> packet;
     Address from;
-    Address localAddress;
     while ((packet = socket->RecvFrom(from))) {
-      socket->GetSockName(localAddress);
-      if (InetSocketAddress::IsMatchingType(from)) {
-        uint8_t recvData[packet->GetSize()];
-        packet->CopyData(recvData, packet->GetSize());
-        uint32_t frameNum;
-        uint32_t packetNum;
-        sscanf((char *)recvData, "fn:%u pn:%u", &frameNum, &packetNum);
-        m_FramePacketCounter[frameNum][packetNum] = true;
-
-        bool BREaK = false;
-        for (int frame_idx = m_lastRecvFrame; frame_idx < TOTAL_VIDEO_FRAME; frame_idx++) {
-          for (int p_idx = 0; p_idx < int(m_resolution) / MAX_PACKET_SIZE + 1; p_idx++) {
-            if(m_FramePacketCounter[frame_idx][p_idx] == false) {
-              BREaK = true;
-              break;
-            } else {
-              if (int(m_resolution) % MAX_PACKET_SIZE == 0){
-                if (int(m_resolution) / MAX_PACKET_SIZE == p_idx + 1){
-                  m_lastRecvFrame = frame_idx + 1;
-                  m_currentBufferSize++;
-                  break;
-                }
-              } else {
-                if (int(m_resolution) / MAX_PACKET_SIZE == p_idx){
-                  m_lastRecvFrame = frame_idx + 1;
-                  m_currentBufferSize++;
-                  break;
-                }
-              }
-            }
-          }
-          if(BREaK == true){
-            break;
-          }
+      if (InetSocketAddress::IsMatchingType(from) || Inet6SocketAddress::IsMatchingType(from)) {
+        if (!m_stream || socket != m_socket) {
+          HandleMessage(packet);
+          continue;
+        }
+        // Over TCP the bytes are those of a stream, cut back into messages.
+        m_framer.Push(packet);
+        Ptr<Packet> message;
+        while ((message = m_framer.Pop())) {
+          HandleMessage(message);
         }
-        
       }
     }
   }
 
+  void VideoStreamClient::HandleMessage(Ptr<Packet> packet) {
+    m_rxTrace(packet);
+    VideoStreamHeader header;
+    packet->RemoveHeader(header);
+    if (header.GetType() == VideoStreamHeader::CONTROL_ACK) {
+      HandleControlAck(header);
+      return;
+    }
+    if (header.GetType() == VideoStreamHeader::RESET) {
+      HandleReset(header);
+      return;
+    }
+    if (header.GetType() == VideoStreamHeader::MANIFEST) {
+      VideoStreamManifestHeader manifest;
+      packet->RemoveHeader(manifest);
+      if (m_representations.empty() && !manifest.GetRepresentations().empty()) {
+        m_representations = manifest.GetRepresentations();
+        m_totalFrames = manifest.GetTotalFrames();
+        // No fragment arrived yet: size the reassembly buffer for the largest frame.
+        if (manifest.GetMaxFragments() > m_maxFragments) {
+          m_reassembler = FrameReassembler(m_reassemblyWindow, manifest.GetMaxFragments());
+        }
+        m_reassembler.SetFec(manifest.GetFecGroupSize(), manifest.GetFecParity());
+        m_live = manifest.IsLive();
+        m_liveStart = manifest.GetLiveStart();
+        m_abr->SetRepresentations(m_representations);
+        m_videoLevel = m_representations.size() - 1;
+        m_frameRate = m_representations[m_videoLevel].m_frameRate;
+        UpdatePlaybackRate();
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s client received a manifest with " << m_representations.size() << " levels and " << m_totalFrames << " frames");
+        if (m_multicast && !manifest.GetMulticastGroup().IsAny()) {
+          m_multicastGroup = manifest.GetMulticastGroup();
+          m_multicastPort = manifest.GetMulticastPort();
+          JoinGroup();
+        } else {
+          SendRequest();
+        }
+      }
+      return;
+    }
+    if (header.GetType() != VideoStreamHeader::DATA) {
+      return;
+    }
+    if (!m_receivedData) {
+      // A live stream is joined at whatever frame is on air.
+      if (m_live) {
+        m_reassembler.Restart(header.GetFrameNumber());
+        m_lastRecvFrame = header.GetFrameNumber();
+      }
+      m_receivedData = true;
+    }
+    // Reception statistics for the next receiver report. Sequence numbers
+    // are 16 bits wide and extended to 32 as in RTP.
+    uint16_t sequence = header.GetSequence();
+    if (!m_reportStarted) {
+      m_reportStarted = true;
+      m_maxSequence = sequence;
+      m_reportSequence = m_maxSequence - 1;
+      m_lastReport = Simulator::Now();
+    } else if ((int16_t) (sequence - (uint16_t) m_maxSequence) > 0) {
+      m_maxSequence += (int16_t) (sequence - (uint16_t) m_maxSequence);
+    }
+    m_reportFragments++;
+    m_reportBytes += packet->GetSize() + header.GetSerializedSize();
+    m_delaySum += Simulator::Now() - header.GetTxTime();
+    m_lastDataTx = header.GetTxTime();
+    m_lastDataArrival = Simulator::Now();
+
+    if (!m_frameTimed) {
+      m_frameStart = Simulator::Now();
+      m_frameTimed = true;
+    }
+    uint32_t watermark = m_reassembler.GetWatermark();
+    uint32_t discarded = m_reassembler.GetDiscardedFragments();
+    uint32_t completed = m_reassembler.AddFragment(header.GetFrameNumber(), header.GetFragmentIndex(), header.GetFragmentCount());
+    if (m_reassembler.GetDiscardedFragments() != discarded) {
+      m_discardTrace(packet);
+    }
+    for (uint32_t frame = watermark; frame < watermark + completed; frame++) {
+      m_frameCompletedTrace(frame);
+    }
+    if (completed > 0) {
+      // Report the frames just completed to the ABR algorithm, timed from
+      // the first fragment received after the previous completion.
+      Time downloadTime = Simulator::Now() - m_frameStart;
+      if (downloadTime.IsStrictlyPositive()) {
+        m_abr->ReportFrame(header.GetFrameSize() * completed, downloadTime);
+      }
+      m_frameTimed = false;
+    }
+    m_recoveredFragments = m_reassembler.GetRecoveredFragments();
+    m_currentBufferSize += completed;
+    m_lastRecvFrame = m_reassembler.GetWatermark();
+    if (completed > 0) {
+      TryStartPlayback();
+    }
+  }
+
 } // namespace ns3
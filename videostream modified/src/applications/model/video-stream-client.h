@@ -7,16 +7,21 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "ns3/nstime.h"
+#include "abr-algorithm.h"
+#include "frame-reassembler.h"
+#include "playback-speed-controller.h"
+#include "video-stream-header.h"
+#include "video-stream-framer.h"
 
 #include <fstream>
+#include <list>
 #include <unordered_map>
 #include <cmath>
 
-#define MAX_PACKET_SIZE 30000      
-#define TOTAL_VIDEO_FRAME 300   
-#define RESOLUTION 300001          // {76800, 230400, 409920, 921600, 2073600}
-
 namespace ns3 {
 
 class Socket;
@@ -27,6 +32,38 @@ class VideoStreamClient : public Application
 public:
 
   static TypeId GetTypeId (void);
+
+  /**
+   * @brief TracedCallback signature of a frame event.
+   *
+   * @param frame the frame number
+   */
+  typedef void (* FrameCallback)(uint32_t frame);
+
+  /**
+   * @brief TracedCallback signature of a level switch.
+   *
+   * @param oldLevel the level played so far
+   * @param newLevel the level requested from now on
+   */
+  typedef void (* LevelSwitchCallback)(uint32_t oldLevel, uint32_t newLevel);
+
+  /**
+   * @brief TracedCallback signature of a playback progress report.
+   *
+   * @param position the media time played so far
+   * @param bitrate the bitrate of the level being played, in bits per second
+   */
+  typedef void (* PlaybackCallback)(Time position, double bitrate);
+
+  /**
+   * @brief TracedCallback signature of the latency of a live frame.
+   *
+   * @param frame the frame played
+   * @param latency from the capture of the frame at the origin to its playback
+   */
+  typedef void (* FrameLatencyCallback)(uint32_t frame, Time latency);
+
   VideoStreamClient ();
   virtual ~VideoStreamClient ();
 
@@ -43,38 +80,156 @@ private:
 
   void Send (void);
 
+  void SendMessage (Ptr<Packet> message);
+
+  void SendControl (VideoStreamHeader header, Ptr<Packet> body);
+
+  void HandleControlAck (const VideoStreamHeader &header);
+
+  void HandleRto (void);
+
+  void ScheduleRto (void);
+
+  void SendManifestRequest (void);
+
+  void SendRequest (void);
+
+  void SendLevelChange (void);
+
+  void SendNack (void);
+
+  void SendReport (void);
+
+  void JoinGroup (void);
+
+  void SendJoin (void);
+
+  void HandleReset (const VideoStreamHeader &header);
+
+  void SelectLevel (void);
+
   uint32_t ReadFromBuffer (void);
 
+  void UpdatePlaybackRate (void);
+
+  Time GetCaptureTime (uint32_t frame) const;
+
+  Time GetLiveLatency (void) const;
+
+  void AdjustSpeed (void);
+
+  void TryStartPlayback (void);
+
+  void PlayFrame (void);
+
   void HandleRead (Ptr<Socket> socket);
 
+  void HandleMessage (Ptr<Packet> packet);
+
   Ptr<Socket> m_socket;           
+  Ptr<Socket> m_multicastSocket;
+  TypeId m_protocol;
+  bool m_stream;                  // TCP: messages are length prefixed, nothing is lost
+  VideoStreamFramer m_framer;
   Address m_peerAddress;          
   uint16_t m_peerPort;           
 
   uint16_t m_initialDelay; 
-  uint16_t m_stopCounter;  
   uint16_t m_rebufferCounter;  
   
 
-  uint32_t m_resolution;  
   uint32_t m_videoLevel;  
 
   uint32_t m_frameRate;  
-  double m_videoSpeed;  
+  double m_videoSpeed;      // nominal speed, the PlaybackSpeed attribute
+  TracedValue<double> m_speed;  // speed currently played at
+  bool m_adaptiveSpeed;
+  Ptr<PlaybackSpeedController> m_speedController;
   uint32_t m_speedxframeRate;
 
-  uint32_t m_frameSize;  
   uint32_t m_lastRecvFrame;  
-  uint32_t m_lastBufferSize;  
   uint32_t m_currentBufferSize;  
 
   uint32_t m_videotime;
+  uint32_t m_totalFrames;
 
   EventId m_bufferEvent;  
+  EventId m_playEvent;
+  Time m_frameInterval;   // time between two frames played
   EventId m_sendEvent;   
 
-  bool m_FramePacketCounter[TOTAL_VIDEO_FRAME][RESOLUTION/MAX_PACKET_SIZE + 1];
-  uint32_t m_resolutionArray[6]; 
+  uint32_t m_reassemblyWindow;
+  uint32_t m_maxFragments;
+  uint32_t m_maxNackSize;
+  FrameReassembler m_reassembler;
+
+  TracedCallback<Ptr<const Packet> > m_rxTrace;
+  TracedCallback<Ptr<const Packet> > m_discardTrace;
+  TracedCallback<uint32_t> m_frameCompletedTrace;
+  TracedCallback<Time> m_startupTrace;
+  TracedCallback<uint32_t> m_stallStartTrace;
+  TracedCallback<Time> m_stallEndTrace;
+  TracedCallback<uint32_t, uint32_t> m_levelSwitchTrace;
+  TracedCallback<Time, double> m_playbackTrace;
+  TracedCallback<uint32_t, Time> m_frameLatencyTrace;
+  TracedValue<uint32_t> m_recoveredFragments;
+  std::vector<VideoStreamRepresentation> m_representations;
+
+  TypeId m_abrTypeId;
+  Ptr<AbrAlgorithm> m_abr;
+  Time m_frameStart;
+  bool m_frameTimed;
+
+  bool m_multicast;
+  Ipv4Address m_multicastGroup;
+  uint16_t m_multicastPort;
+  bool m_receivedData;
+  bool m_live;            // the server produces the frames in real time
+  Time m_liveStart;       // capture time of frame 0 at the server
+
+  /**
+   * @brief Control message waiting for its acknowledgment.
+   */
+  typedef struct PendingControl
+  {
+    VideoStreamHeader m_header;
+    Ptr<Packet> m_body;       // what follows the header
+    uint32_t m_retries;
+    Time m_deadline;          // when it is resent without an acknowledgment
+  } PendingControl;
+
+  std::list<PendingControl> m_pendingControl; // oldest first
+  uint16_t m_controlSequence; // sequence number of the next control message
+  Time m_srtt;              // smoothed round-trip time, zero until measured
+  Time m_rttVar;
+  Time m_rto;
+  Time m_initialRto;
+  Time m_minRto;
+  uint32_t m_maxControlRetries;
+  EventId m_rtoEvent;
+  TracedValue<uint32_t> m_controlRetransmissions;
+
+  Time m_reportInterval;
+  Time m_maxBuffer;         // playback time the server may fill the buffer up to
+  EventId m_reportEvent;
+  bool m_reportStarted;     // a data fragment has set the sequence base
+  uint32_t m_maxSequence;   // highest extended sequence number received
+  uint32_t m_reportSequence; // m_maxSequence at the previous report
+  uint32_t m_reportFragments; // fragments received since the previous report
+  uint32_t m_reportBytes;
+  Time m_delaySum;          // one-way delays of the fragments since the previous report
+  Time m_lastMeanDelay;     // mean one-way delay of the previous report, negative if none
+  Time m_lastReport;
+  Time m_lastDataTx;        // transmission time of the newest fragment
+  Time m_lastDataArrival;
+
+  Time m_requestTime;     // when the manifest was first asked for
+  bool m_playing;         // playback has started
+  bool m_playbackAllowed; // the initial delay is over
+  bool m_ended;           // the whole video has been played
+  bool m_stalled;
+  Time m_stallStart;
+  uint32_t m_playedFrames;
 };
 } // namespace ns3
 
@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "video-stream-framer.h"
+#include "video-stream-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamFramer");
+
+VideoStreamFramer::VideoStreamFramer ()
+  : m_buffer (Create<Packet> ())
+{
+}
+
+Ptr<Packet>
+VideoStreamFramer::Frame (Ptr<const Packet> message)
+{
+  VideoStreamLengthHeader length;
+  length.SetLength (message->GetSize ());
+  Ptr<Packet> framed = message->Copy ();
+  framed->AddHeader (length);
+  return framed;
+}
+
+void
+VideoStreamFramer::Push (Ptr<const Packet> bytes)
+{
+  m_buffer->AddAtEnd (bytes);
+}
+
+Ptr<Packet>
+VideoStreamFramer::Pop (void)
+{
+  VideoStreamLengthHeader length;
+  if (m_buffer->GetSize () < length.GetSerializedSize ())
+    {
+      return 0;
+    }
+  m_buffer->PeekHeader (length);
+  if (m_buffer->GetSize () < length.GetSerializedSize () + length.GetLength ())
+    {
+      NS_LOG_LOGIC ("Waiting for " << length.GetSerializedSize () + length.GetLength () - m_buffer->GetSize () << " more bytes");
+      return 0;
+    }
+  m_buffer->RemoveHeader (length);
+  Ptr<Packet> message = m_buffer->CreateFragment (0, length.GetLength ());
+  m_buffer->RemoveAtStart (length.GetLength ());
+  return message;
+}
+
+uint32_t
+VideoStreamFramer::GetBufferedBytes (void) const
+{
+  return m_buffer->GetSize ();
+}
+
+} // namespace ns3
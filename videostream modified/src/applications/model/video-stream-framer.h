@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef VIDEO_STREAM_FRAMER_H
+#define VIDEO_STREAM_FRAMER_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+/**
+ * @brief Cut the byte stream of a TCP connection back into messages.
+ *
+ * Every message is sent with a VideoStreamLengthHeader in front of it. The
+ * bytes received are appended to a buffer, and complete messages are taken
+ * out of its front, whatever the segment boundaries were.
+ */
+class VideoStreamFramer
+{
+public:
+  VideoStreamFramer ();
+
+  /**
+   * @brief Prefix a message with its length, for sending on a stream.
+   *
+   * @param message the message, left untouched
+   * @return a copy of the message with the prefix
+   */
+  static Ptr<Packet> Frame (Ptr<const Packet> message);
+
+  /**
+   * @brief Append the bytes received from the stream.
+   *
+   * @param bytes the bytes, in stream order
+   */
+  void Push (Ptr<const Packet> bytes);
+
+  /**
+   * @brief Take out the oldest complete message.
+   *
+   * @return the message without its prefix, 0 if none is complete yet
+   */
+  Ptr<Packet> Pop (void);
+
+  /**
+   * @brief Get the bytes buffered, of messages not complete yet.
+   *
+   * @return the byte count
+   */
+  uint32_t GetBufferedBytes (void) const;
+
+private:
+  Ptr<Packet> m_buffer;
+};
+
+} // namespace ns3
+
+#endif /* VIDEO_STREAM_FRAMER_H */
@@ -0,0 +1,709 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "video-stream-header.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamHeader);
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamManifestHeader);
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamNackHeader);
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamReceiverReportHeader);
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamLengthHeader);
+
+VideoStreamHeader::VideoStreamHeader ()
+  : m_type (REQUEST),
+    m_level (0),
+    m_frameRate (0),
+    m_frameNumber (0),
+    m_fragmentIndex (0),
+    m_fragmentCount (0),
+    m_sequence (0),
+    m_frameSize (0),
+    m_txTime (0),
+    m_echoTime (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+VideoStreamHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+VideoStreamHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+VideoStreamHeader::Print (std::ostream &os) const
+{
+  os << "type=" << (uint32_t) m_type
+     << " level=" << m_level
+     << " fr=" << m_frameRate
+     << " frame=" << m_frameNumber
+     << " fragment=" << m_fragmentIndex << "/" << m_fragmentCount
+     << " seq=" << m_sequence
+     << " size=" << m_frameSize
+     << " tx=" << TimeStep (m_txTime)
+     << " echo=" << TimeStep (m_echoTime);
+}
+
+uint32_t
+VideoStreamHeader::GetSerializedSize (void) const
+{
+  return 1 + 2 + 2 + 4 + 2 + 2 + 2 + 4 + 8 + 8;
+}
+
+void
+VideoStreamHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (m_type);
+  i.WriteHtonU16 (m_level);
+  i.WriteHtonU16 (m_frameRate);
+  i.WriteHtonU32 (m_frameNumber);
+  i.WriteHtonU16 (m_fragmentIndex);
+  i.WriteHtonU16 (m_fragmentCount);
+  i.WriteHtonU16 (m_sequence);
+  i.WriteHtonU32 (m_frameSize);
+  i.WriteHtonU64 (m_txTime);
+  i.WriteHtonU64 (m_echoTime);
+}
+
+uint32_t
+VideoStreamHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_type = i.ReadU8 ();
+  m_level = i.ReadNtohU16 ();
+  m_frameRate = i.ReadNtohU16 ();
+  m_frameNumber = i.ReadNtohU32 ();
+  m_fragmentIndex = i.ReadNtohU16 ();
+  m_fragmentCount = i.ReadNtohU16 ();
+  m_sequence = i.ReadNtohU16 ();
+  m_frameSize = i.ReadNtohU32 ();
+  m_txTime = i.ReadNtohU64 ();
+  m_echoTime = i.ReadNtohU64 ();
+  return GetSerializedSize ();
+}
+
+void
+VideoStreamHeader::SetType (MessageType type)
+{
+  m_type = type;
+}
+
+VideoStreamHeader::MessageType
+VideoStreamHeader::GetType (void) const
+{
+  return static_cast<MessageType> (m_type);
+}
+
+void
+VideoStreamHeader::SetLevel (uint16_t level)
+{
+  m_level = level;
+}
+
+uint16_t
+VideoStreamHeader::GetLevel (void) const
+{
+  return m_level;
+}
+
+void
+VideoStreamHeader::SetFrameRate (uint16_t frameRate)
+{
+  m_frameRate = frameRate;
+}
+
+uint16_t
+VideoStreamHeader::GetFrameRate (void) const
+{
+  return m_frameRate;
+}
+
+void
+VideoStreamHeader::SetFrameNumber (uint32_t frameNumber)
+{
+  m_frameNumber = frameNumber;
+}
+
+uint32_t
+VideoStreamHeader::GetFrameNumber (void) const
+{
+  return m_frameNumber;
+}
+
+void
+VideoStreamHeader::SetFragmentIndex (uint16_t fragmentIndex)
+{
+  m_fragmentIndex = fragmentIndex;
+}
+
+uint16_t
+VideoStreamHeader::GetFragmentIndex (void) const
+{
+  return m_fragmentIndex;
+}
+
+void
+VideoStreamHeader::SetFragmentCount (uint16_t fragmentCount)
+{
+  m_fragmentCount = fragmentCount;
+}
+
+uint16_t
+VideoStreamHeader::GetFragmentCount (void) const
+{
+  return m_fragmentCount;
+}
+
+void
+VideoStreamHeader::SetSequence (uint16_t sequence)
+{
+  m_sequence = sequence;
+}
+
+uint16_t
+VideoStreamHeader::GetSequence (void) const
+{
+  return m_sequence;
+}
+
+void
+VideoStreamHeader::SetFrameSize (uint32_t frameSize)
+{
+  m_frameSize = frameSize;
+}
+
+uint32_t
+VideoStreamHeader::GetFrameSize (void) const
+{
+  return m_frameSize;
+}
+
+void
+VideoStreamHeader::SetTxTime (Time txTime)
+{
+  m_txTime = txTime.GetTimeStep ();
+}
+
+Time
+VideoStreamHeader::GetTxTime (void) const
+{
+  return TimeStep (m_txTime);
+}
+
+void
+VideoStreamHeader::SetEchoTime (Time echoTime)
+{
+  m_echoTime = echoTime.GetTimeStep ();
+}
+
+Time
+VideoStreamHeader::GetEchoTime (void) const
+{
+  return TimeStep (m_echoTime);
+}
+
+VideoStreamManifestHeader::VideoStreamManifestHeader ()
+  : m_totalFrames (0),
+    m_multicastGroup (Ipv4Address::GetAny ()),
+    m_multicastPort (0),
+    m_maxFragments (1),
+    m_fecGroupSize (1),
+    m_fecParity (0),
+    m_live (0),
+    m_liveStart (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+VideoStreamManifestHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamManifestHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamManifestHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+VideoStreamManifestHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+VideoStreamManifestHeader::Print (std::ostream &os) const
+{
+  os << "frames=" << m_totalFrames << " maxFragments=" << m_maxFragments << " fec=" << m_fecParity << "/" << m_fecGroupSize
+     << " multicast=" << m_multicastGroup << ":" << m_multicastPort;
+  if (m_live)
+    {
+      os << " live=" << TimeStep (m_liveStart);
+    }
+  for (std::vector<VideoStreamRepresentation>::const_iterator it = m_representations.begin ();
+       it != m_representations.end (); it++)
+    {
+      os << " [level=" << it->m_level << " size=" << it->m_frameSize << " fr=" << it->m_frameRate << "]";
+    }
+}
+
+uint32_t
+VideoStreamManifestHeader::GetSerializedSize (void) const
+{
+  return 4 + 4 + 2 + 2 + 2 + 2 + 1 + 8 + 2 + m_representations.size () * (2 + 4 + 2);
+}
+
+void
+VideoStreamManifestHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_totalFrames);
+  i.WriteHtonU32 (m_multicastGroup.Get ());
+  i.WriteHtonU16 (m_multicastPort);
+  i.WriteHtonU16 (m_maxFragments);
+  i.WriteHtonU16 (m_fecGroupSize);
+  i.WriteHtonU16 (m_fecParity);
+  i.WriteU8 (m_live);
+  i.WriteHtonU64 (m_liveStart);
+  i.WriteHtonU16 (m_representations.size ());
+  for (std::vector<VideoStreamRepresentation>::const_iterator it = m_representations.begin ();
+       it != m_representations.end (); it++)
+    {
+      i.WriteHtonU16 (it->m_level);
+      i.WriteHtonU32 (it->m_frameSize);
+      i.WriteHtonU16 (it->m_frameRate);
+    }
+}
+
+uint32_t
+VideoStreamManifestHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_totalFrames = i.ReadNtohU32 ();
+  m_multicastGroup.Set (i.ReadNtohU32 ());
+  m_multicastPort = i.ReadNtohU16 ();
+  m_maxFragments = i.ReadNtohU16 ();
+  m_fecGroupSize = i.ReadNtohU16 ();
+  m_fecParity = i.ReadNtohU16 ();
+  m_live = i.ReadU8 ();
+  m_liveStart = i.ReadNtohU64 ();
+  uint16_t count = i.ReadNtohU16 ();
+  m_representations.resize (count);
+  for (uint16_t n = 0; n < count; n++)
+    {
+      m_representations[n].m_level = i.ReadNtohU16 ();
+      m_representations[n].m_frameSize = i.ReadNtohU32 ();
+      m_representations[n].m_frameRate = i.ReadNtohU16 ();
+    }
+  return GetSerializedSize ();
+}
+
+void
+VideoStreamManifestHeader::SetTotalFrames (uint32_t totalFrames)
+{
+  m_totalFrames = totalFrames;
+}
+
+uint32_t
+VideoStreamManifestHeader::GetTotalFrames (void) const
+{
+  return m_totalFrames;
+}
+
+void
+VideoStreamManifestHeader::SetRepresentations (const std::vector<VideoStreamRepresentation> &representations)
+{
+  m_representations = representations;
+}
+
+const std::vector<VideoStreamRepresentation> &
+VideoStreamManifestHeader::GetRepresentations (void) const
+{
+  return m_representations;
+}
+
+void
+VideoStreamManifestHeader::SetMaxFragments (uint16_t maxFragments)
+{
+  m_maxFragments = maxFragments;
+}
+
+uint16_t
+VideoStreamManifestHeader::GetMaxFragments (void) const
+{
+  return m_maxFragments;
+}
+
+void
+VideoStreamManifestHeader::SetFec (uint16_t groupSize, uint16_t parity)
+{
+  m_fecGroupSize = groupSize;
+  m_fecParity = parity;
+}
+
+uint16_t
+VideoStreamManifestHeader::GetFecGroupSize (void) const
+{
+  return m_fecGroupSize;
+}
+
+uint16_t
+VideoStreamManifestHeader::GetFecParity (void) const
+{
+  return m_fecParity;
+}
+
+void
+VideoStreamManifestHeader::SetMulticast (Ipv4Address group, uint16_t port)
+{
+  m_multicastGroup = group;
+  m_multicastPort = port;
+}
+
+Ipv4Address
+VideoStreamManifestHeader::GetMulticastGroup (void) const
+{
+  return m_multicastGroup;
+}
+
+uint16_t
+VideoStreamManifestHeader::GetMulticastPort (void) const
+{
+  return m_multicastPort;
+}
+
+void
+VideoStreamManifestHeader::SetLive (bool live, Time start)
+{
+  m_live = live;
+  m_liveStart = start.GetTimeStep ();
+}
+
+bool
+VideoStreamManifestHeader::IsLive (void) const
+{
+  return m_live;
+}
+
+Time
+VideoStreamManifestHeader::GetLiveStart (void) const
+{
+  return TimeStep (m_liveStart);
+}
+
+VideoStreamNackHeader::VideoStreamNackHeader ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+VideoStreamNackHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamNackHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamNackHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+VideoStreamNackHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+VideoStreamNackHeader::Print (std::ostream &os) const
+{
+  os << "frames=" << m_frames.size ();
+  for (std::vector<VideoStreamNackEntry>::const_iterator it = m_frames.begin ();
+       it != m_frames.end (); it++)
+    {
+      os << " [frame=" << it->m_frameNumber << " fragments=" << it->m_fragmentCount << "]";
+    }
+}
+
+uint32_t
+VideoStreamNackHeader::GetEntrySize (const VideoStreamNackEntry &entry)
+{
+  return 4 + 2 + (entry.m_fragmentCount + 7) / 8;
+}
+
+uint32_t
+VideoStreamNackHeader::GetSerializedSize (void) const
+{
+  uint32_t size = 2;
+  for (std::vector<VideoStreamNackEntry>::const_iterator it = m_frames.begin ();
+       it != m_frames.end (); it++)
+    {
+      size += GetEntrySize (*it);
+    }
+  return size;
+}
+
+void
+VideoStreamNackHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU16 (m_frames.size ());
+  for (std::vector<VideoStreamNackEntry>::const_iterator it = m_frames.begin ();
+       it != m_frames.end (); it++)
+    {
+      i.WriteHtonU32 (it->m_frameNumber);
+      i.WriteHtonU16 (it->m_fragmentCount);
+      for (uint32_t n = 0; n < (it->m_fragmentCount + 7u) / 8; n++)
+        {
+          i.WriteU8 (n < it->m_missing.size () ? it->m_missing[n] : 0);
+        }
+    }
+}
+
+uint32_t
+VideoStreamNackHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint16_t count = i.ReadNtohU16 ();
+  m_frames.resize (count);
+  for (uint16_t n = 0; n < count; n++)
+    {
+      m_frames[n].m_frameNumber = i.ReadNtohU32 ();
+      m_frames[n].m_fragmentCount = i.ReadNtohU16 ();
+      m_frames[n].m_missing.resize ((m_frames[n].m_fragmentCount + 7) / 8);
+      for (uint32_t b = 0; b < m_frames[n].m_missing.size (); b++)
+        {
+          m_frames[n].m_missing[b] = i.ReadU8 ();
+        }
+    }
+  return GetSerializedSize ();
+}
+
+void
+VideoStreamNackHeader::AddFrame (const VideoStreamNackEntry &entry)
+{
+  m_frames.push_back (entry);
+}
+
+const std::vector<VideoStreamNackEntry> &
+VideoStreamNackHeader::GetFrames (void) const
+{
+  return m_frames;
+}
+
+VideoStreamReceiverReportHeader::VideoStreamReceiverReportHeader ()
+  : m_receivedBytes (0),
+    m_interval (0),
+    m_lossFraction (0),
+    m_delayGradient (0),
+    m_holdTime (0),
+    m_headroom (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+VideoStreamReceiverReportHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamReceiverReportHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamReceiverReportHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+VideoStreamReceiverReportHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+VideoStreamReceiverReportHeader::Print (std::ostream &os) const
+{
+  os << "bytes=" << m_receivedBytes
+     << " interval=" << m_interval << "us"
+     << " loss=" << (uint32_t) m_lossFraction << "/256"
+     << " gradient=" << m_delayGradient << "us"
+     << " hold=" << m_holdTime << "us"
+     << " headroom=" << m_headroom;
+}
+
+uint32_t
+VideoStreamReceiverReportHeader::GetSerializedSize (void) const
+{
+  return 4 + 4 + 1 + 4 + 4 + 4;
+}
+
+void
+VideoStreamReceiverReportHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_receivedBytes);
+  i.WriteHtonU32 (m_interval);
+  i.WriteU8 (m_lossFraction);
+  i.WriteHtonU32 (static_cast<uint32_t> (m_delayGradient));
+  i.WriteHtonU32 (m_holdTime);
+  i.WriteHtonU32 (m_headroom);
+}
+
+uint32_t
+VideoStreamReceiverReportHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_receivedBytes = i.ReadNtohU32 ();
+  m_interval = i.ReadNtohU32 ();
+  m_lossFraction = i.ReadU8 ();
+  m_delayGradient = static_cast<int32_t> (i.ReadNtohU32 ());
+  m_holdTime = i.ReadNtohU32 ();
+  m_headroom = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+void
+VideoStreamReceiverReportHeader::SetReceived (uint32_t bytes, Time interval)
+{
+  m_receivedBytes = bytes;
+  m_interval = interval.GetMicroSeconds ();
+}
+
+uint32_t
+VideoStreamReceiverReportHeader::GetReceivedBytes (void) const
+{
+  return m_receivedBytes;
+}
+
+Time
+VideoStreamReceiverReportHeader::GetInterval (void) const
+{
+  return MicroSeconds (m_interval);
+}
+
+void
+VideoStreamReceiverReportHeader::SetLossFraction (double lossFraction)
+{
+  m_lossFraction = std::min (255.0, std::max (0.0, lossFraction * 256));
+}
+
+double
+VideoStreamReceiverReportHeader::GetLossFraction (void) const
+{
+  return m_lossFraction / 256.0;
+}
+
+void
+VideoStreamReceiverReportHeader::SetDelayGradient (Time gradient)
+{
+  m_delayGradient = gradient.GetMicroSeconds ();
+}
+
+Time
+VideoStreamReceiverReportHeader::GetDelayGradient (void) const
+{
+  return MicroSeconds (m_delayGradient);
+}
+
+void
+VideoStreamReceiverReportHeader::SetHoldTime (Time holdTime)
+{
+  m_holdTime = holdTime.GetMicroSeconds ();
+}
+
+Time
+VideoStreamReceiverReportHeader::GetHoldTime (void) const
+{
+  return MicroSeconds (m_holdTime);
+}
+
+void
+VideoStreamReceiverReportHeader::SetHeadroom (uint32_t frames)
+{
+  m_headroom = frames;
+}
+
+uint32_t
+VideoStreamReceiverReportHeader::GetHeadroom (void) const
+{
+  return m_headroom;
+}
+
+VideoStreamLengthHeader::VideoStreamLengthHeader ()
+  : m_length (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+VideoStreamLengthHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamLengthHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamLengthHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+VideoStreamLengthHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+VideoStreamLengthHeader::Print (std::ostream &os) const
+{
+  os << "length=" << m_length;
+}
+
+uint32_t
+VideoStreamLengthHeader::GetSerializedSize (void) const
+{
+  return 4;
+}
+
+void
+VideoStreamLengthHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (m_length);
+}
+
+uint32_t
+VideoStreamLengthHeader::Deserialize (Buffer::Iterator start)
+{
+  m_length = start.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+void
+VideoStreamLengthHeader::SetLength (uint32_t length)
+{
+  m_length = length;
+}
+
+uint32_t
+VideoStreamLengthHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+} // namespace ns3
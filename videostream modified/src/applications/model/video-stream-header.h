@@ -0,0 +1,355 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef VIDEO_STREAM_HEADER_H
+#define VIDEO_STREAM_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Fixed-layout header carried by every packet exchanged between
+ * VideoStreamClient and VideoStreamServer.
+ *
+ * The message type tells the receiver which of the remaining fields are
+ * meaningful: a request carries the first frame wanted, the quality level and
+ * the consumption frame rate, a data packet carries the frame number and the
+ * position of the fragment inside that frame.
+ */
+class VideoStreamHeader : public Header
+{
+public:
+  /**
+   * @brief Kind of message carried by the packet.
+   */
+  enum MessageType
+  {
+    REQUEST = 1,          //!< client asks for frames starting at the frame number
+    DATA = 2,             //!< one fragment of a video frame
+    LEVEL_CHANGE = 3,     //!< client switched quality level, no frames requested
+    MANIFEST_REQUEST = 4, //!< client asks for the list of representations
+    MANIFEST = 5,         //!< server lists its representations, see VideoStreamManifestHeader
+    NACK = 6,             //!< client lists missing fragments, see VideoStreamNackHeader
+    JOIN = 7,             //!< client joined the multicast group of the level
+    RECEIVER_REPORT = 8,  //!< client reports the reception, see VideoStreamReceiverReportHeader
+    CONTROL_ACK = 9,      //!< server acknowledges the control message of the sequence number
+    RESET = 10            //!< server acknowledges it, but has no session for the client any more
+  };
+
+  VideoStreamHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  void SetType (MessageType type);
+  MessageType GetType (void) const;
+
+  void SetLevel (uint16_t level);
+  uint16_t GetLevel (void) const;
+
+  void SetFrameRate (uint16_t frameRate);
+  uint16_t GetFrameRate (void) const;
+
+  void SetFrameNumber (uint32_t frameNumber);
+  uint32_t GetFrameNumber (void) const;
+
+  void SetFragmentIndex (uint16_t fragmentIndex);
+  uint16_t GetFragmentIndex (void) const;
+
+  void SetFragmentCount (uint16_t fragmentCount);
+  uint16_t GetFragmentCount (void) const;
+
+  /**
+   * @brief Set the sequence number of a data fragment or a control message.
+   * Every fragment sent to a session, resent ones included, takes the next
+   * number, wrapping around as in RTP, so that the receiver can count the
+   * losses. Control messages from the client are numbered apart, and a
+   * CONTROL_ACK or RESET carries the number it acknowledges.
+   *
+   * @param sequence the sequence number
+   */
+  void SetSequence (uint16_t sequence);
+  uint16_t GetSequence (void) const;
+
+  /**
+   * @brief Set the size of the whole frame a data fragment belongs to, in
+   * bytes. Requests carry only the level, not a frame size.
+   *
+   * @param frameSize the frame size in bytes
+   */
+  void SetFrameSize (uint32_t frameSize);
+  uint32_t GetFrameSize (void) const;
+
+  /**
+   * @brief Set the time at which the sender emitted the packet.
+   *
+   * @param txTime the transmission time
+   */
+  void SetTxTime (Time txTime);
+  Time GetTxTime (void) const;
+
+  /**
+   * @brief Set the transmission time of the last packet received from the
+   * peer, so that the peer can measure the round-trip time.
+   *
+   * @param echoTime the echoed transmission time
+   */
+  void SetEchoTime (Time echoTime);
+  Time GetEchoTime (void) const;
+
+private:
+  uint8_t m_type;
+  uint16_t m_level;
+  uint16_t m_frameRate;
+  uint32_t m_frameNumber;
+  uint16_t m_fragmentIndex;
+  uint16_t m_fragmentCount;
+  uint16_t m_sequence;
+  uint32_t m_frameSize;
+  uint64_t m_txTime;
+  uint64_t m_echoTime;
+};
+
+/**
+ * @brief One quality level of the content.
+ */
+struct VideoStreamRepresentation
+{
+  uint16_t m_level;      //!< index of the level, 0 being the lowest quality
+  uint32_t m_frameSize;  //!< mean size of a frame in bytes
+  uint16_t m_frameRate;  //!< frames per second at normal playback speed
+};
+
+/**
+ * @brief Body of a MANIFEST message, following the VideoStreamHeader.
+ *
+ * Lists every representation the server can stream, ordered by level, the
+ * length of the content in frames, the largest data fragment count of a
+ * frame, the FEC layout of the data fragments, in multicast mode where every
+ * level is multicast and, for a live stream, when frame 0 was captured.
+ */
+class VideoStreamManifestHeader : public Header
+{
+public:
+  VideoStreamManifestHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  void SetTotalFrames (uint32_t totalFrames);
+  uint32_t GetTotalFrames (void) const;
+
+  void SetRepresentations (const std::vector<VideoStreamRepresentation> &representations);
+  const std::vector<VideoStreamRepresentation> &GetRepresentations (void) const;
+
+  /**
+   * @brief Set the largest number of data fragments any frame of any level
+   * is split into, so the client sizes its reassembly buffer.
+   *
+   * @param maxFragments the largest fragment count
+   */
+  void SetMaxFragments (uint16_t maxFragments);
+  uint16_t GetMaxFragments (void) const;
+
+  /**
+   * @brief Set the FEC layout: every group of data fragments of a frame is
+   * followed by parity fragments, numbered after the last data fragment.
+   *
+   * @param groupSize the data fragments per group
+   * @param parity the parity fragments per group, 0 without FEC
+   */
+  void SetFec (uint16_t groupSize, uint16_t parity);
+  uint16_t GetFecGroupSize (void) const;
+  uint16_t GetFecParity (void) const;
+
+  /**
+   * @brief Set the multicast groups: level l is sent to the group address
+   * plus l, on the port plus l.
+   *
+   * @param group the group of level 0, the any address if not multicasting
+   * @param port the port of level 0
+   */
+  void SetMulticast (Ipv4Address group, uint16_t port);
+  Ipv4Address GetMulticastGroup (void) const;
+  uint16_t GetMulticastPort (void) const;
+
+  /**
+   * @brief Mark the stream as live. Frame f of a live stream is captured at
+   * the start time plus f over the frame rate, and is only available from
+   * the server once encoded.
+   *
+   * @param live whether the stream is live
+   * @param start the capture time of frame 0
+   */
+  void SetLive (bool live, Time start);
+  bool IsLive (void) const;
+  Time GetLiveStart (void) const;
+
+private:
+  uint32_t m_totalFrames;
+  Ipv4Address m_multicastGroup;
+  uint16_t m_multicastPort;
+  uint16_t m_maxFragments;
+  uint16_t m_fecGroupSize;
+  uint16_t m_fecParity;
+  uint8_t m_live;
+  uint64_t m_liveStart;
+  std::vector<VideoStreamRepresentation> m_representations;
+};
+
+/**
+ * @brief Missing fragments of one frame, as reported in a NACK.
+ */
+struct VideoStreamNackEntry
+{
+  uint32_t m_frameNumber;         //!< frame the fragments belong to
+  uint16_t m_fragmentCount;       //!< fragment count of the frame, 0 if none arrived
+  std::vector<uint8_t> m_missing; //!< bit i set if fragment i is missing, lowest bit first
+};
+
+/**
+ * @brief Body of a NACK message, following the VideoStreamHeader.
+ *
+ * Lists the incomplete frames the client knows of. A frame of which some
+ * fragments arrived carries a bitmap of the missing ones, one bit per
+ * fragment; a frame of which nothing arrived has a zero fragment count and no
+ * bitmap, and asks for the whole frame.
+ */
+class VideoStreamNackHeader : public Header
+{
+public:
+  VideoStreamNackHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * @brief Add a frame to the list.
+   *
+   * @param entry the frame and its missing fragments
+   */
+  void AddFrame (const VideoStreamNackEntry &entry);
+  const std::vector<VideoStreamNackEntry> &GetFrames (void) const;
+
+  /**
+   * @brief Get the serialized size of an entry.
+   *
+   * @param entry the entry
+   * @return the size in bytes
+   */
+  static uint32_t GetEntrySize (const VideoStreamNackEntry &entry);
+
+private:
+  std::vector<VideoStreamNackEntry> m_frames;
+};
+
+/**
+ * @brief Body of a RECEIVER_REPORT message, following the VideoStreamHeader.
+ *
+ * Describes the data received since the previous report, in the manner of an
+ * RTCP receiver report. The echo time of the VideoStreamHeader is the
+ * transmission time of the newest fragment received, and the hold time is
+ * how long ago it arrived, so the server measures the round-trip time as
+ * now minus the echo time minus the hold time. The frame number of the
+ * VideoStreamHeader is the client's watermark, and the headroom the number
+ * of frames past it the client can take.
+ */
+class VideoStreamReceiverReportHeader : public Header
+{
+public:
+  VideoStreamReceiverReportHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * @brief Set the bytes received over the report interval.
+   *
+   * @param bytes the bytes of every fragment received, headers included
+   * @param interval the time since the previous report
+   */
+  void SetReceived (uint32_t bytes, Time interval);
+  uint32_t GetReceivedBytes (void) const;
+  Time GetInterval (void) const;
+
+  /**
+   * @brief Set the share of the fragments lost over the interval.
+   *
+   * @param lossFraction the lost fragments over the expected ones, between
+   *        0 and 1, carried in 1/256 units
+   */
+  void SetLossFraction (double lossFraction);
+  double GetLossFraction (void) const;
+
+  /**
+   * @brief Set the one-way delay gradient: the mean one-way delay of the
+   * fragments of the interval minus the one of the previous interval.
+   *
+   * @param gradient the gradient, positive when queues build up
+   */
+  void SetDelayGradient (Time gradient);
+  Time GetDelayGradient (void) const;
+
+  void SetHoldTime (Time holdTime);
+  Time GetHoldTime (void) const;
+
+  void SetHeadroom (uint32_t frames);
+  uint32_t GetHeadroom (void) const;
+
+private:
+  uint32_t m_receivedBytes;
+  uint32_t m_interval;       // microseconds
+  uint8_t m_lossFraction;    // 1/256 units
+  int32_t m_delayGradient;   // microseconds
+  uint32_t m_holdTime;       // microseconds
+  uint32_t m_headroom;       // frames
+};
+
+/**
+ * @brief Length prefix of a message sent over a stream socket.
+ *
+ * A byte stream has no message boundaries, so over TCP every message, i.e. a
+ * VideoStreamHeader and what follows it, is preceded by its length.
+ */
+class VideoStreamLengthHeader : public Header
+{
+public:
+  VideoStreamLengthHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  void SetLength (uint32_t length);
+  uint32_t GetLength (void) const;
+
+private:
+  uint32_t m_length;
+};
+
+} // namespace ns3
+
+#endif /* VIDEO_STREAM_HEADER_H */
@@ -0,0 +1,308 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "video-stream-qoe-collector.h"
+#include "video-stream-client.h"
+#include "video-stream-server.h"
+#include "video-stream-header.h"
+
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VideoStreamQoeCollector");
+
+NS_OBJECT_ENSURE_REGISTERED (VideoStreamQoeCollector);
+
+VideoStreamQoeCollector::SessionStats::SessionStats ()
+  : m_nodeId (0),
+    m_started (false),
+    m_stalls (0),
+    m_stalled (false),
+    m_bitrateTime (0),
+    m_switches (0),
+    m_completedFrames (0),
+    m_rxBytes (0),
+    m_wastedBytes (0),
+    m_liveFrames (0)
+{
+}
+
+double
+VideoStreamQoeCollector::SessionStats::GetRebufferRatio (void) const
+{
+  if (!m_started)
+    {
+      return 0;
+    }
+  Time stallTime = m_stallTime;
+  Time end = m_lastProgress;
+  if (m_stalled)
+    {
+      stallTime += Simulator::Now () - m_stallStart;
+      end = Simulator::Now ();
+    }
+  Time span = end - m_startTime;
+  return span.IsStrictlyPositive () ? stallTime.GetSeconds () / span.GetSeconds () : 0;
+}
+
+double
+VideoStreamQoeCollector::SessionStats::GetAverageBitrate (void) const
+{
+  return m_position.IsStrictlyPositive () ? m_bitrateTime / m_position.GetSeconds () : 0;
+}
+
+Time
+VideoStreamQoeCollector::SessionStats::GetAverageLatency (void) const
+{
+  return m_liveFrames ? Seconds (m_latencySum.GetSeconds () / m_liveFrames) : Time (0);
+}
+
+VideoStreamQoeCollector::PeerStats::PeerStats ()
+  : m_sentBytes (0),
+    m_retransmittedBytes (0)
+{
+}
+
+TypeId
+VideoStreamQoeCollector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VideoStreamQoeCollector")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<VideoStreamQoeCollector> ()
+  ;
+  return tid;
+}
+
+VideoStreamQoeCollector::VideoStreamQoeCollector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+VideoStreamQoeCollector::~VideoStreamQoeCollector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+VideoStreamQoeCollector::Install (Ptr<VideoStreamClient> client)
+{
+  NS_LOG_FUNCTION (this << client);
+  // The context of every connection is the index of the session.
+  std::ostringstream context;
+  context << m_sessions.size ();
+  m_sessions.push_back (SessionStats ());
+  m_sessions.back ().m_nodeId = client->GetNode ()->GetId ();
+
+  client->TraceConnect ("Rx", context.str (), MakeCallback (&VideoStreamQoeCollector::Rx, this));
+  client->TraceConnect ("Discard", context.str (), MakeCallback (&VideoStreamQoeCollector::Discard, this));
+  client->TraceConnect ("FrameCompleted", context.str (), MakeCallback (&VideoStreamQoeCollector::FrameCompleted, this));
+  client->TraceConnect ("Startup", context.str (), MakeCallback (&VideoStreamQoeCollector::Startup, this));
+  client->TraceConnect ("StallStart", context.str (), MakeCallback (&VideoStreamQoeCollector::StallStart, this));
+  client->TraceConnect ("StallEnd", context.str (), MakeCallback (&VideoStreamQoeCollector::StallEnd, this));
+  client->TraceConnect ("LevelSwitch", context.str (), MakeCallback (&VideoStreamQoeCollector::LevelSwitch, this));
+  client->TraceConnect ("PlaybackProgress", context.str (), MakeCallback (&VideoStreamQoeCollector::PlaybackProgress, this));
+  client->TraceConnect ("FrameLatency", context.str (), MakeCallback (&VideoStreamQoeCollector::FrameLatency, this));
+}
+
+void
+VideoStreamQoeCollector::Install (Ptr<VideoStreamServer> server)
+{
+  NS_LOG_FUNCTION (this << server);
+  server->TraceConnectWithoutContext ("FragmentSent", MakeCallback (&VideoStreamQoeCollector::FragmentSent, this));
+  server->TraceConnectWithoutContext ("FragmentRetransmitted", MakeCallback (&VideoStreamQoeCollector::FragmentRetransmitted, this));
+}
+
+void
+VideoStreamQoeCollector::Install (ApplicationContainer apps)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator it = apps.Begin (); it != apps.End (); it++)
+    {
+      Ptr<VideoStreamClient> client = DynamicCast<VideoStreamClient> (*it);
+      if (client)
+        {
+          Install (client);
+          continue;
+        }
+      Ptr<VideoStreamServer> server = DynamicCast<VideoStreamServer> (*it);
+      if (server)
+        {
+          Install (server);
+        }
+    }
+}
+
+uint32_t
+VideoStreamQoeCollector::GetNSessions (void) const
+{
+  return m_sessions.size ();
+}
+
+const VideoStreamQoeCollector::SessionStats &
+VideoStreamQoeCollector::GetSessionStats (uint32_t session) const
+{
+  NS_ASSERT (session < m_sessions.size ());
+  return m_sessions[session];
+}
+
+const std::map<Address, VideoStreamQoeCollector::PeerStats> &
+VideoStreamQoeCollector::GetPeerStats (void) const
+{
+  return m_peers;
+}
+
+void
+VideoStreamQoeCollector::WriteSessions (std::ostream &os) const
+{
+  os << "session,node,startupDelay,stalls,stallTime,rebufferRatio,averageBitrate,"
+     << "switches,completedFrames,rxBytes,wastedBytes,averageLatency,maxLatency" << std::endl;
+  for (uint32_t session = 0; session < m_sessions.size (); session++)
+    {
+      const SessionStats &stats = m_sessions[session];
+      Time stallTime = stats.m_stallTime;
+      if (stats.m_stalled)
+        {
+          stallTime += Simulator::Now () - stats.m_stallStart;
+        }
+      os << session << ","
+         << stats.m_nodeId << ","
+         << (stats.m_started ? stats.m_startupDelay.GetSeconds () : -1) << ","
+         << stats.m_stalls << ","
+         << stallTime.GetSeconds () << ","
+         << stats.GetRebufferRatio () << ","
+         << stats.GetAverageBitrate () << ","
+         << stats.m_switches << ","
+         << stats.m_completedFrames << ","
+         << stats.m_rxBytes << ","
+         << stats.m_wastedBytes << ","
+         << stats.GetAverageLatency ().GetSeconds () << ","
+         << stats.m_maxLatency.GetSeconds () << std::endl;
+    }
+}
+
+void
+VideoStreamQoeCollector::WritePeers (std::ostream &os) const
+{
+  os << "address,port,sentBytes,retransmittedBytes" << std::endl;
+  for (std::map<Address, PeerStats>::const_iterator it = m_peers.begin (); it != m_peers.end (); it++)
+    {
+      if (InetSocketAddress::IsMatchingType (it->first))
+        {
+          InetSocketAddress address = InetSocketAddress::ConvertFrom (it->first);
+          os << address.GetIpv4 () << "," << address.GetPort ();
+        }
+      else if (Inet6SocketAddress::IsMatchingType (it->first))
+        {
+          Inet6SocketAddress address = Inet6SocketAddress::ConvertFrom (it->first);
+          os << address.GetIpv6 () << "," << address.GetPort ();
+        }
+      else
+        {
+          continue;
+        }
+      os << "," << it->second.m_sentBytes << "," << it->second.m_retransmittedBytes << std::endl;
+    }
+}
+
+VideoStreamQoeCollector::SessionStats &
+VideoStreamQoeCollector::GetSession (std::string context)
+{
+  uint32_t session = 0;
+  std::istringstream (context) >> session;
+  NS_ASSERT (session < m_sessions.size ());
+  return m_sessions[session];
+}
+
+void
+VideoStreamQoeCollector::Rx (std::string context, Ptr<const Packet> packet)
+{
+  GetSession (context).m_rxBytes += packet->GetSize ();
+}
+
+void
+VideoStreamQoeCollector::Discard (std::string context, Ptr<const Packet> packet)
+{
+  // The client reports the payload, its header was already removed.
+  GetSession (context).m_wastedBytes += packet->GetSize () + VideoStreamHeader ().GetSerializedSize ();
+}
+
+void
+VideoStreamQoeCollector::FrameCompleted (std::string context, uint32_t frame)
+{
+  GetSession (context).m_completedFrames++;
+}
+
+void
+VideoStreamQoeCollector::Startup (std::string context, Time delay)
+{
+  NS_LOG_FUNCTION (this << context << delay);
+  SessionStats &stats = GetSession (context);
+  stats.m_started = true;
+  stats.m_startupDelay = delay;
+  stats.m_startTime = Simulator::Now ();
+  stats.m_lastProgress = Simulator::Now ();
+}
+
+void
+VideoStreamQoeCollector::StallStart (std::string context, uint32_t frame)
+{
+  NS_LOG_FUNCTION (this << context << frame);
+  SessionStats &stats = GetSession (context);
+  stats.m_stalls++;
+  stats.m_stalled = true;
+  stats.m_stallStart = Simulator::Now ();
+}
+
+void
+VideoStreamQoeCollector::StallEnd (std::string context, Time duration)
+{
+  NS_LOG_FUNCTION (this << context << duration);
+  SessionStats &stats = GetSession (context);
+  stats.m_stalled = false;
+  stats.m_stallTime += duration;
+}
+
+void
+VideoStreamQoeCollector::LevelSwitch (std::string context, uint32_t oldLevel, uint32_t newLevel)
+{
+  NS_LOG_FUNCTION (this << context << oldLevel << newLevel);
+  GetSession (context).m_switches++;
+}
+
+void
+VideoStreamQoeCollector::PlaybackProgress (std::string context, Time position, double bitrate)
+{
+  SessionStats &stats = GetSession (context);
+  stats.m_bitrateTime += bitrate * (position - stats.m_position).GetSeconds ();
+  stats.m_position = position;
+  stats.m_lastProgress = Simulator::Now ();
+}
+
+void
+VideoStreamQoeCollector::FrameLatency (std::string context, uint32_t frame, Time latency)
+{
+  SessionStats &stats = GetSession (context);
+  stats.m_liveFrames++;
+  stats.m_latencySum += latency;
+  stats.m_maxLatency = Max (stats.m_maxLatency, latency);
+}
+
+void
+VideoStreamQoeCollector::FragmentSent (Ptr<const Packet> packet, const Address &address)
+{
+  m_peers[address].m_sentBytes += packet->GetSize ();
+}
+
+void
+VideoStreamQoeCollector::FragmentRetransmitted (Ptr<const Packet> packet, const Address &address)
+{
+  m_peers[address].m_retransmittedBytes += packet->GetSize ();
+}
+
+} // namespace ns3
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef VIDEO_STREAM_QOE_COLLECTOR_H
+#define VIDEO_STREAM_QOE_COLLECTOR_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/application-container.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class VideoStreamClient;
+class VideoStreamServer;
+
+/**
+ * @brief Aggregate the QoE of video streaming sessions from trace sources.
+ *
+ * Every installed client is one session. Its startup delay, stalls, level
+ * switches, played bitrate, received bytes and, for live streams, the
+ * glass-to-glass latency are collected from the client trace sources, so
+ * configurations can be compared without parsing the standard output.
+ * Installed servers additionally account the bytes sent and resent to every
+ * peer address.
+ */
+class VideoStreamQoeCollector : public Object
+{
+public:
+  /**
+   * @brief Statistics of one client session.
+   */
+  struct SessionStats
+  {
+    SessionStats ();
+
+    /**
+     * @brief Get the share of the session spent stalled, once playing.
+     *
+     * @return the stall time over the time from playback start to the last
+     *         progress report, or to now if the session is stalled
+     */
+    double GetRebufferRatio (void) const;
+
+    /**
+     * @brief Get the average bitrate of the media played.
+     *
+     * @return the bitrate weighted by media time, in bits per second
+     */
+    double GetAverageBitrate (void) const;
+
+    /**
+     * @brief Get the average glass-to-glass latency of a live session.
+     *
+     * @return the mean latency of the frames played, zero if none was live
+     */
+    Time GetAverageLatency (void) const;
+
+    uint32_t m_nodeId;           //!< node of the client
+    bool m_started;              //!< playback has started
+    Time m_startupDelay;         //!< from the first manifest request to playback
+    Time m_startTime;            //!< when playback started
+    uint32_t m_stalls;           //!< stalls after playback started
+    bool m_stalled;              //!< the session is stalled now
+    Time m_stallStart;           //!< start of the current stall
+    Time m_stallTime;            //!< total time of the finished stalls
+    Time m_lastProgress;         //!< time of the last playback progress
+    Time m_position;             //!< media time played
+    double m_bitrateTime;        //!< bitrate integrated over media time, in bits
+    uint32_t m_switches;         //!< level switches
+    uint32_t m_completedFrames;  //!< frames completely received
+    uint64_t m_rxBytes;          //!< bytes of every fragment received
+    uint64_t m_wastedBytes;      //!< bytes of fragments that brought nothing new
+    uint32_t m_liveFrames;       //!< live frames played
+    Time m_latencySum;           //!< sum of the latencies of the live frames
+    Time m_maxLatency;           //!< largest latency of a live frame
+  };
+
+  /**
+   * @brief Bytes a server sent to one peer address.
+   */
+  struct PeerStats
+  {
+    PeerStats ();
+
+    uint64_t m_sentBytes;          //!< first transmissions, parity included
+    uint64_t m_retransmittedBytes; //!< transmissions after a NACK
+  };
+
+  static TypeId GetTypeId (void);
+
+  VideoStreamQoeCollector ();
+  virtual ~VideoStreamQoeCollector ();
+
+  /**
+   * @brief Collect the statistics of a client as a new session.
+   *
+   * @param client the client application
+   */
+  void Install (Ptr<VideoStreamClient> client);
+
+  /**
+   * @brief Collect the bytes a server sends to its peers.
+   *
+   * @param server the server application
+   */
+  void Install (Ptr<VideoStreamServer> server);
+
+  /**
+   * @brief Install every video stream client and server of a container,
+   * other applications are skipped.
+   *
+   * @param apps the applications
+   */
+  void Install (ApplicationContainer apps);
+
+  /**
+   * @brief Get the number of sessions, i.e. of installed clients.
+   *
+   * @return the session count
+   */
+  uint32_t GetNSessions (void) const;
+
+  /**
+   * @brief Get the statistics of a session.
+   *
+   * @param session the index of the session, in installation order
+   * @return the statistics collected so far
+   */
+  const SessionStats &GetSessionStats (uint32_t session) const;
+
+  /**
+   * @brief Get the bytes sent to every peer of the installed servers.
+   *
+   * @return the statistics by peer socket address
+   */
+  const std::map<Address, PeerStats> &GetPeerStats (void) const;
+
+  /**
+   * @brief Write one CSV row per session, with a header line.
+   *
+   * @param os the output stream
+   */
+  void WriteSessions (std::ostream &os) const;
+
+  /**
+   * @brief Write one CSV row per server peer, with a header line.
+   *
+   * @param os the output stream
+   */
+  void WritePeers (std::ostream &os) const;
+
+private:
+  SessionStats &GetSession (std::string context);
+
+  void Rx (std::string context, Ptr<const Packet> packet);
+  void Discard (std::string context, Ptr<const Packet> packet);
+  void FrameCompleted (std::string context, uint32_t frame);
+  void Startup (std::string context, Time delay);
+  void StallStart (std::string context, uint32_t frame);
+  void StallEnd (std::string context, Time duration);
+  void LevelSwitch (std::string context, uint32_t oldLevel, uint32_t newLevel);
+  void PlaybackProgress (std::string context, Time position, double bitrate);
+  void FrameLatency (std::string context, uint32_t frame, Time latency);
+  void FragmentSent (Ptr<const Packet> packet, const Address &address);
+  void FragmentRetransmitted (Ptr<const Packet> packet, const Address &address);
+
+  std::vector<SessionStats> m_sessions;
+  std::map<Address, PeerStats> m_peers;
+};
+
+} // namespace ns3
+
+#endif /* VIDEO_STREAM_QOE_COLLECTOR_H */
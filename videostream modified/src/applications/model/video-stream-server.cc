@@ -7,18 +7,38 @@
 #include "ns3/inet6-socket-address.h"
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
 #include "video-stream-server.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
 namespace ns3 {
 
   NS_LOG_COMPONENT_DEFINE("VideoStreamServerApplication");
 
   NS_OBJECT_ENSURE_REGISTERED(VideoStreamServer);
 
+  static std::string PeerName(const Address &address) {
+    std::ostringstream name;
+    if (InetSocketAddress::IsMatchingType(address)) {
+      name << InetSocketAddress::ConvertFrom(address).GetIpv4() << " port " << InetSocketAddress::ConvertFrom(address).GetPort();
+    } else if (Inet6SocketAddress::IsMatchingType(address)) {
+      name << Inet6SocketAddress::ConvertFrom(address).GetIpv6() << " port " << Inet6SocketAddress::ConvertFrom(address).GetPort();
+    }
+    return name.str();
+  }
+
   TypeId VideoStreamServer::GetTypeId(void) {
     static TypeId tid = TypeId("ns3::VideoStreamServer")
                             .SetParent<Application>()
@@ -32,6 +52,133 @@ namespace ns3 {
                                           UintegerValue(5000),
                                           MakeUintegerAccessor(&VideoStreamServer::m_port),
                                           MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("Protocol", "Socket factory of the transport, UDP or TCP",
+                                          TypeIdValue(UdpSocketFactory::GetTypeId()),
+                                          MakeTypeIdAccessor(&VideoStreamServer::m_protocol),
+                                          MakeTypeIdChecker())
+                            .AddAttribute("FrameFile", "Trace file with the size of every frame at every level, empty for fixed-size frames",
+                                          StringValue(""),
+                                          MakeStringAccessor(&VideoStreamServer::SetFrameFile,
+                                                             &VideoStreamServer::GetFrameFile),
+                                          MakeStringChecker())
+                            .AddAttribute("Representations", "Frame size in bytes of every level, lowest first, used when there is no FrameFile",
+                                          StringValue("100001 150001 200001 230001 250001 300001"),
+                                          MakeStringAccessor(&VideoStreamServer::m_representationList),
+                                          MakeStringChecker())
+                            .AddAttribute("FrameRate", "Frames per second of the content at normal playback speed",
+                                          UintegerValue(5),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_contentFrameRate),
+                                          MakeUintegerChecker<uint16_t>(1))
+                            .AddAttribute("MaxPacketSize", "Largest UDP payload of a fragment, header included",
+                                          UintegerValue(1400),
+                                          MakeUintegerAccessor(&VideoStreamServer::SetMaxPacketSize,
+                                                               &VideoStreamServer::GetMaxPacketSize),
+                                          MakeUintegerChecker<uint32_t>(64, 65507))
+                            .AddAttribute("FecGroupSize", "Data fragments protected by each group of parity fragments",
+                                          UintegerValue(8),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_fecGroupSize),
+                                          MakeUintegerChecker<uint16_t>(1))
+                            .AddAttribute("FecParity", "Parity fragments sent after each group of data fragments (1 is XOR, more is Reed-Solomon), 0 disables FEC",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_fecParity),
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("PacingRate", "Rate at which the fragments of each client are paced out",
+                                          DataRateValue(DataRate("20Mb/s")),
+                                          MakeDataRateAccessor(&VideoStreamServer::m_pacingRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("PacingBurst", "Token bucket depth of each client's pacer, in bytes, at least MaxPacketSize",
+                                          UintegerValue(60000),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_pacingBurst),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("ServerPacingRate", "Rate at which the fragments of all clients together are paced out, 0 for no server-wide cap",
+                                          DataRateValue(DataRate("0b/s")),
+                                          MakeDataRateAccessor(&VideoStreamServer::m_serverPacingRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("ServerPacingBurst", "Token bucket depth of the server-wide pacer, in bytes, at least MaxPacketSize",
+                                          UintegerValue(60000),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_serverPacingBurst),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("Quantum", "Bytes a client of weight 1 may send per round of the fair scheduler",
+                                          UintegerValue(1500),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_quantum),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("LevelWeights", "Scheduling weight of a client at every level, lowest first, separated by spaces or commas, the last one applying to the levels above; empty for equal weights",
+                                          StringValue(""),
+                                          MakeStringAccessor(&VideoStreamServer::m_weightList),
+                                          MakeStringChecker())
+                            .AddAttribute("FairnessInterval", "Interval between two throughput and fairness reports, 0 to disable them",
+                                          TimeValue(Seconds(1.0)),
+                                          MakeTimeAccessor(&VideoStreamServer::m_fairnessInterval),
+                                          MakeTimeChecker(Seconds(0.0)))
+                            .AddAttribute("MulticastGroup", "Group address of level 0 in multicast live mode, level l using the address plus l; the any address disables the mode",
+                                          Ipv4AddressValue(Ipv4Address::GetAny()),
+                                          MakeIpv4AddressAccessor(&VideoStreamServer::m_multicastGroup),
+                                          MakeIpv4AddressChecker())
+                            .AddAttribute("MulticastPort", "Destination port of level 0 in multicast live mode, level l using the port plus l",
+                                          UintegerValue(6000),
+                                          MakeUintegerAccessor(&VideoStreamServer::m_multicastPort),
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("MinWindow", "Shortest media time a client's send window covers past its watermark",
+                                          TimeValue(Seconds(1.0)),
+                                          MakeTimeAccessor(&VideoStreamServer::m_minWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxWindow", "Longest media time a client's send window covers past its watermark",
+                                          TimeValue(Seconds(10.0)),
+                                          MakeTimeAccessor(&VideoStreamServer::m_maxWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("WindowGain", "Send window over the bandwidth-delay product, above 1 to let the window grow",
+                                          DoubleValue(2.0),
+                                          MakeDoubleAccessor(&VideoStreamServer::m_windowGain),
+                                          MakeDoubleChecker<double>(1.0))
+                            .AddAttribute("RateControl", "Send to every unicast UDP client at the rate a GccRateController derives from its receiver reports",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&VideoStreamServer::m_rateControl),
+                                          MakeBooleanChecker())
+                            .AddAttribute("Live", "Produce the frames in real time at the content frame rate, each frame being sent once encoded, instead of serving a stored video",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&VideoStreamServer::m_live),
+                                          MakeBooleanChecker())
+                            .AddAttribute("EncodeDelay", "Time from the capture of a live frame to the end of its encoding",
+                                          TimeValue(Seconds(0.2)),
+                                          MakeTimeAccessor(&VideoStreamServer::m_encodeDelay),
+                                          MakeTimeChecker(Seconds(0.0)))
+                            .AddAttribute("IdleTimeout", "Time without any packet from a client after which its session is dropped",
+                                          TimeValue(Seconds(10.0)),
+                                          MakeTimeAccessor(&VideoStreamServer::m_idleTimeout),
+                                          MakeTimeChecker(Seconds(0.0)))
+                            .AddTraceSource("ActiveSessions", "Number of client sessions",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_sessions),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("QueuedFragments", "Fragments waiting in the per-client pacers",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_queuedFragments),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("DroppedFragments", "Fragments the socket refused to send",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_droppedFragments),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("RetransmittedFragments", "Fragments resent after a NACK",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_retransmittedFragments),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("ParityFragments", "FEC parity fragments sent",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_parityFragments),
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("ClientThroughput", "Throughput in bit/s sent to a client or multicast group over the last fairness interval",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_clientThroughputTrace),
+                                            "ns3::VideoStreamServer::ThroughputCallback")
+                            .AddTraceSource("Fairness", "Jain's fairness index of the client throughputs over the last fairness interval",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_fairnessTrace),
+                                            "ns3::VideoStreamServer::FairnessCallback")
+                            .AddTraceSource("SendRate", "Send rate in bit/s of a client, updated on every receiver report under rate control",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_sendRateTrace),
+                                            "ns3::VideoStreamServer::ThroughputCallback")
+                            .AddTraceSource("Tx", "A fragment has been sent",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_txTrace),
+                                            "ns3::Packet::TracedCallback")
+                            .AddTraceSource("FragmentSent", "A fragment has been sent to a client for the first time",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_fragmentSentTrace),
+                                            "ns3::Packet::AddressTracedCallback")
+                            .AddTraceSource("FragmentRetransmitted", "A fragment has been resent to a client after a NACK",
+                                            MakeTraceSourceAccessor(&VideoStreamServer::m_fragmentRetransmittedTrace),
+                                            "ns3::Packet::AddressTracedCallback")
         ;
     return tid;
   }
@@ -39,22 +186,42 @@ namespace ns3 {
   VideoStreamServer::VideoStreamServer() {
     NS_LOG_FUNCTION(this);
     m_socket = 0;
+    m_stream = false;
+    m_queuedFragments = 0;
+    m_droppedFragments = 0;
+    m_retransmittedFragments = 0;
+    m_parityFragments = 0;
+    m_sessions = 0;
+    m_serverTokens = 0;
+    m_liveFrame = 0;
   }
 
   VideoStreamServer::~VideoStreamServer() {
     NS_LOG_FUNCTION(this);
     m_socket = 0;
+    m_socket6 = 0;
+  }
+
+  size_t VideoStreamServer::AddressHash::operator()(const Address &address) const {
+    // FNV-1a over the serialized address: type, length, IP address and port.
+    uint8_t buffer[Address::MAX_SIZE + 2];
+    uint32_t length = address.CopyAllTo(buffer, sizeof(buffer));
+    size_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; i++) {
+      hash = (hash ^ buffer[i]) * 16777619u;
+    }
+    return hash;
   }
 
   void VideoStreamServer::DoDispose(void) {
     NS_LOG_FUNCTION(this);
+    m_frameTrace = 0;
     Application::DoDispose();
   }
   void VideoStreamServer::StartApplication(void) {
     NS_LOG_FUNCTION(this);
     if (m_socket == 0) {
-      TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-      m_socket = Socket::CreateSocket(GetNode(), tid);
+      m_socket = Socket::CreateSocket(GetNode(), m_protocol);
       InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), m_port);
       if (m_socket->Bind(local) == -1) {
         NS_FATAL_ERROR("Error: Failed to bind socket");
@@ -68,9 +235,174 @@ namespace ns3 {
       }
     }
 
-    m_socket->SetAllowBroadcast(true);
+    if (m_socket6 == 0) {
+      m_socket6 = Socket::CreateSocket(GetNode(), m_protocol);
+      Inet6SocketAddress local6 = Inet6SocketAddress(Ipv6Address::GetAny(), m_port);
+      if (m_socket6->Bind(local6) == -1) {
+        NS_FATAL_ERROR("Error: Failed to bind socket");
+      }
+    }
+
+    m_stream = m_socket->GetSocketType() == Socket::NS3_SOCK_STREAM;
+    if (m_stream) {
+      if (!m_multicastGroup.IsAny()) {
+        NS_FATAL_ERROR("Error: Multicast needs a datagram transport");
+      }
+      // Every client gets a connection of its own, accepted here.
+      m_socket->Listen();
+      m_socket6->Listen();
+      m_socket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address &>(),
+                                  MakeCallback(&VideoStreamServer::HandleAccept, this));
+      m_socket6->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address &>(),
+                                   MakeCallback(&VideoStreamServer::HandleAccept, this));
+    } else {
+      m_socket->SetAllowBroadcast(true);
+      m_socket->SetRecvCallback(MakeCallback(&VideoStreamServer::HandleRead, this));
+      m_socket6->SetRecvCallback(MakeCallback(&VideoStreamServer::HandleRead, this));
+    }
+
+    if (!m_frameFile.empty()) {
+      m_frameTrace = VideoFrameTrace::Get(m_frameFile, m_maxPacketSize - VideoStreamHeader().GetSerializedSize(), m_fecParity ? m_fecGroupSize : 0);
+    }
+    BuildRepresentations();
+
+    // Weights are separated by white space or commas.
+    m_weights.clear();
+    std::string weightList = m_weightList;
+    std::replace(weightList.begin(), weightList.end(), ',', ' ');
+    std::istringstream weights(weightList);
+    double weight;
+    while (weights >> weight) {
+      if (weight <= 0) {
+        NS_FATAL_ERROR("Error: Scheduling weights must be positive");
+      }
+      m_weights.push_back(weight);
+    }
+    if (!weights.eof()) {
+      NS_FATAL_ERROR("Error: Malformed scheduling weights \"" << m_weightList << "\"");
+    }
+
+    m_serverTokens = m_serverPacingBurst;
+    m_serverRefill = Simulator::Now();
+    if (m_fairnessInterval.IsStrictlyPositive()) {
+      m_fairnessEvent = Simulator::Schedule(m_fairnessInterval, &VideoStreamServer::ReportFairness, this);
+    }
+    if (IsLive()) {
+      StartLive();
+    }
+  }
+
+  void VideoStreamServer::StartLive(void) {
+    // In multicast mode every level gets a session of its own, sending to the
+    // level's group through the same scheduler as the unicast clients.
+    m_groups.clear();
+    for (uint32_t level = 0; !m_multicastGroup.IsAny() && level < m_representations.size(); level++) {
+      // Groups are not client sessions: they are not looked up and never expire.
+      ClientInfo *group = AllocateClient(InetSocketAddress(Ipv4Address(m_multicastGroup.Get() + level), m_multicastPort + level));
+      group->m_videoLevel = level;
+      group->m_frameRate = m_contentFrameRate;
+      m_groups.push_back(group);
+    }
+    // Frame 0 is captured now and can be sent once encoded.
+    m_liveFrame = 0;
+    m_liveStart = Simulator::Now();
+    m_liveEvent = Simulator::Schedule(m_encodeDelay, &VideoStreamServer::LiveTick, this);
+  }
+
+  void VideoStreamServer::LiveTick(void) {
+    // Frame m_liveFrame is encoded now: every level with viewers sends it
+    // once to its group, whatever the number of viewers.
+    for (std::vector<ClientInfo*>::iterator it = m_groups.begin(); it != m_groups.end(); it++) {
+      ClientInfo *group = *it;
+      group->m_windowEnd = m_liveFrame + 1;
+      if (group->m_members == 0) {
+        group->m_nextFrame = m_liveFrame + 1;
+        group->m_nextPacket = 0;
+      } else {
+        Activate(group);
+      }
+      UpdateBacklog(group);
+      // Keep the frames a client may still repair, five seconds as for a unicast window.
+      uint32_t repairFrames = m_contentFrameRate * 5;
+      if (m_liveFrame >= repairFrames) {
+        group->m_sentFrames.erase(group->m_sentFrames.begin(), group->m_sentFrames.lower_bound(m_liveFrame - repairFrames));
+      }
+    }
+    if (IsLive()) {
+      // Unicast sessions waiting for the frame get it pushed right away.
+      for (auto iter = m_clients.begin(); iter != m_clients.end(); iter++) {
+        ClientInfo *client = iter->second;
+        uint32_t windowEnd = std::min(client->m_requestEnd, m_liveFrame + 1);
+        if (client->m_group == 0 && client->m_windowEnd < windowEnd) {
+          client->m_windowEnd = windowEnd;
+          UpdateBacklog(client);
+          Activate(client);
+        }
+      }
+    }
+    if (++m_liveFrame < GetTotalFrames()) {
+      m_liveEvent = Simulator::Schedule(Seconds(1.0 / m_contentFrameRate), &VideoStreamServer::LiveTick, this);
+    }
+  }
+
+  bool VideoStreamServer::IsLive(void) const {
+    // A multicast server is a live origin for its unicast clients as well.
+    return m_live || !m_multicastGroup.IsAny();
+  }
+
+  uint32_t VideoStreamServer::GetAvailableFrames(void) const {
+    return IsLive() ? m_liveFrame : GetTotalFrames();
+  }
 
-    m_socket->SetRecvCallback(MakeCallback(&VideoStreamServer::HandleRead, this));
+  VideoStreamServer::ClientInfo *VideoStreamServer::GetSource(ClientInfo *client) const {
+    return client->m_group ? client->m_group : client;
+  }
+
+  void VideoStreamServer::Join(ClientInfo *client, uint32_t level) {
+    if (m_groups.empty()) {
+      NS_LOG_WARN("Join from " << PeerName(client->m_address) << " while multicast is disabled");
+      return;
+    }
+    Leave(client);
+    client->m_videoLevel = std::min<uint32_t>(level, m_groups.size() - 1);
+    client->m_group = m_groups[client->m_videoLevel];
+    client->m_group->m_members++;
+    // Unicast frames are replaced by the group's.
+    client->m_windowEnd = client->m_nextFrame;
+    UpdateBacklog(client);
+  }
+
+  void VideoStreamServer::Leave(ClientInfo *client) {
+    if (client->m_group) {
+      client->m_group->m_members--;
+      client->m_group = 0;
+    }
+  }
+
+  void VideoStreamServer::BuildRepresentations(void) {
+    m_representations.clear();
+    if (m_frameTrace) {
+      for (uint32_t level = 0; level < m_frameTrace->GetLevelCount(); level++) {
+        VideoStreamRepresentation representation;
+        representation.m_level = level;
+        representation.m_frameSize = m_frameTrace->GetAverageFrameSize(level);
+        representation.m_frameRate = m_contentFrameRate;
+        m_representations.push_back(representation);
+      }
+    } else {
+      std::istringstream list(m_representationList);
+      uint32_t frameSize;
+      while (list >> frameSize) {
+        VideoStreamRepresentation representation;
+        representation.m_level = m_representations.size();
+        representation.m_frameSize = frameSize;
+        representation.m_frameRate = m_contentFrameRate;
+        m_representations.push_back(representation);
+      }
+    }
+    if (m_representations.empty()) {
+      NS_FATAL_ERROR("Error: No representation to stream");
+    }
   }
 
   void VideoStreamServer::StopApplication() {
@@ -81,92 +413,737 @@ namespace ns3 {
       m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
       m_socket = 0;
     }
+    if (m_socket6 != 0) {
+      m_socket6->Close();
+      m_socket6->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+      m_socket6 = 0;
+    }
+    for (std::map<Ptr<Socket>, Connection>::iterator it = m_connections.begin(); it != m_connections.end(); it++) {
+      it->first->Close();
+      it->first->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+      it->first->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+    }
+    m_connections.clear();
+    Simulator::Cancel(m_sendEvent);
     for (auto iter = m_clients.begin(); iter != m_clients.end(); iter++) {
-      Simulator::Cancel(iter->second->m_sendEvent);
+      Simulator::Cancel(iter->second->m_pacingEvent);
     }
+    for (uint32_t level = 0; level < m_groups.size(); level++) {
+      Simulator::Cancel(m_groups[level]->m_pacingEvent);
+    }
+    Simulator::Cancel(m_evictEvent);
+    Simulator::Cancel(m_fairnessEvent);
+    Simulator::Cancel(m_liveEvent);
+  }
+
+  void VideoStreamServer::SetFrameFile(std::string frameFile) {
+    m_frameFile = frameFile;
+  }
+
+  std::string VideoStreamServer::GetFrameFile(void) const {
+    return m_frameFile;
+  }
+
+  void VideoStreamServer::SetMaxPacketSize(uint32_t maxPacketSize) {
+    m_maxPacketSize = maxPacketSize;
   }
 
   uint32_t VideoStreamServer::GetMaxPacketSize(void) const {
-    return MAX_PACKET_SIZE;
+    return m_maxPacketSize;
   }
 
-  void VideoStreamServer::Send(uint32_t ipAddress) {
-    NS_LOG_FUNCTION(this);
+  uint32_t VideoStreamServer::GetTotalFrames(void) const {
+    return m_frameTrace ? m_frameTrace->GetFrameCount() : TOTAL_VIDEO_FRAME;
+  }
 
-    uint32_t resolution;
-    ClientInfo *clientInfo = m_clients.at(ipAddress);
+  uint32_t VideoStreamServer::GetFrameSize(const ClientInfo *client, uint32_t frame_idx) const {
+    return m_frameTrace ? m_frameTrace->GetFrameSize(client->m_videoLevel, frame_idx) : m_representations[client->m_videoLevel].m_frameSize;
+  }
 
-    NS_ASSERT(clientInfo->m_sendEvent.IsExpired());
-    resolution = clientInfo->m_videoLevel;
+  uint32_t VideoStreamServer::GetFragmentCount(uint32_t frameSize) const {
+    uint32_t capacity = m_maxPacketSize - VideoStreamHeader().GetSerializedSize();
+    return std::max((frameSize + capacity - 1) / capacity, 1u);
+  }
 
-    for (uint frame_idx = clientInfo->m_sent; frame_idx < clientInfo->m_sent + clientInfo->m_frameRate * 5; frame_idx++) {
-      if (frame_idx == TOTAL_VIDEO_FRAME) {
-        break;
+  uint32_t VideoStreamServer::GetMaxFragmentCount(void) const {
+    if (m_frameTrace) {
+      return m_frameTrace->GetMaxFragmentCount();
+    }
+    uint32_t maxFragments = 1;
+    for (uint32_t level = 0; level < m_representations.size(); level++) {
+      maxFragments = std::max(maxFragments, GetFragmentCount(m_representations[level].m_frameSize));
+    }
+    return maxFragments;
+  }
+
+  uint32_t VideoStreamServer::GetParityCount(uint32_t fragmentCount) const {
+    return (fragmentCount + m_fecGroupSize - 1) / m_fecGroupSize * m_fecParity;
+  }
+
+  uint32_t VideoStreamServer::GetFragmentPayload(uint32_t frameSize, uint32_t packet_idx) const {
+    uint32_t capacity = m_maxPacketSize - VideoStreamHeader().GetSerializedSize();
+    uint32_t fragmentCount = GetFragmentCount(frameSize);
+    if (packet_idx >= fragmentCount) {
+      // A parity fragment is as large as the first, largest, fragment of its group.
+      packet_idx = (packet_idx - fragmentCount) / m_fecParity * m_fecGroupSize;
+    }
+    return std::min(capacity, frameSize - std::min(frameSize, packet_idx * capacity));
+  }
+
+  void VideoStreamServer::UpdateBacklog(ClientInfo *client) {
+    uint32_t backlog = client->m_retransmissions.size();
+    if (client->m_nextFrame < client->m_windowEnd) {
+      // Whole frames left in the window, starting after a partly sent one.
+      uint32_t from = client->m_nextFrame;
+      if (client->m_nextPacket != 0) {
+        backlog += client->m_frameFragments - client->m_nextPacket;
+        from++;
+      }
+      if (m_frameTrace) {
+        backlog += m_frameTrace->GetFragmentOffset(client->m_videoLevel, client->m_windowEnd)
+                   - m_frameTrace->GetFragmentOffset(client->m_videoLevel, from);
+        backlog += (m_frameTrace->GetGroupOffset(client->m_videoLevel, client->m_windowEnd)
+                    - m_frameTrace->GetGroupOffset(client->m_videoLevel, from)) * m_fecParity;
       } else {
-        for (uint packet_idx = 0; packet_idx < resolution / MAX_PACKET_SIZE + 1; packet_idx++) {
-          if (resolution % MAX_PACKET_SIZE == 0 && packet_idx + 1 == resolution / MAX_PACKET_SIZE) {
-            break;
-          } else {
-            SendPacket(clientInfo, frame_idx, packet_idx);
-            NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server sent frame " << frame_idx << " and " << resolution << " bytes to " << InetSocketAddress::ConvertFrom(clientInfo->m_address).GetIpv4() << " port " << InetSocketAddress::ConvertFrom(clientInfo->m_address).GetPort());
-          }
+        uint32_t fragmentCount = GetFragmentCount(m_representations[client->m_videoLevel].m_frameSize);
+        backlog += (client->m_windowEnd - from) * (fragmentCount + GetParityCount(fragmentCount));
+      }
+    }
+    m_queuedFragments = m_queuedFragments - client->m_backlog + backlog;
+    client->m_backlog = backlog;
+  }
+
+  void VideoStreamServer::StartWindow(ClientInfo *client) {
+    NS_LOG_FUNCTION(this);
+
+    // Frames already sent are not sent again: the client NACKs what it lost.
+    if (client->m_nextFrame < client->m_sent) {
+      client->m_nextFrame = client->m_sent;
+      client->m_nextPacket = 0;
+    }
+    client->m_requestEnd = std::min(client->m_sent + GetWindowFrames(client), GetTotalFrames());
+    client->m_windowEnd = std::min(client->m_requestEnd, GetAvailableFrames());
+    UpdateBacklog(client);
+  }
+
+  uint32_t VideoStreamServer::GetWindowFrames(const ClientInfo *client) const {
+    // Until measured, five seconds of frames at the client's consumption rate.
+    double frameRate = client->m_frameRate;
+    double frames = frameRate * 5;
+    if (client->m_rtt.IsStrictlyPositive() && client->m_deliveryRate > 0) {
+      // Keep the path full until the next report slides the window: the
+      // bandwidth-delay product over the round trip plus the report interval.
+      double bytes = m_windowGain * client->m_deliveryRate / 8 * (client->m_rtt + client->m_reportInterval).GetSeconds();
+      frames = std::ceil(bytes / std::max<uint32_t>(m_representations[client->m_videoLevel].m_frameSize, 1));
+    }
+    frames = std::max(frames, m_minWindow.GetSeconds() * frameRate);
+    frames = std::min(frames, m_maxWindow.GetSeconds() * frameRate);
+    return std::min<double>(frames, client->m_headroom);
+  }
+
+  bool VideoStreamServer::NextFragment(ClientInfo *client, uint32_t &frame_idx, uint32_t &packet_idx, bool &retransmission) {
+    // Retransmissions go ahead of the frames not sent yet.
+    while (!client->m_retransmissions.empty()) {
+      frame_idx = client->m_retransmissions.front().first;
+      packet_idx = client->m_retransmissions.front().second;
+      if (GetSource(client)->m_sentFrames.count(frame_idx)) {
+        retransmission = true;
+        return true;
+      }
+      // Acknowledged since the NACK was handled.
+      client->m_retransmissions.pop_front();
+      UpdateBacklog(client);
+    }
+    if (client->m_nextFrame >= client->m_windowEnd) {
+      return false;
+    }
+    frame_idx = client->m_nextFrame;
+    packet_idx = client->m_nextPacket;
+    retransmission = false;
+    if (packet_idx == 0) {
+      // A level change only takes effect at a frame boundary.
+      client->m_currentFrameSize = GetFrameSize(client, frame_idx);
+      uint32_t fragmentCount = GetFragmentCount(client->m_currentFrameSize);
+      client->m_frameFragments = fragmentCount + GetParityCount(fragmentCount);
+      SentFrame sentFrame;
+      sentFrame.m_videoLevel = client->m_videoLevel;
+      sentFrame.m_frameSize = client->m_currentFrameSize;
+      client->m_sentFrames[frame_idx] = sentFrame;
+    }
+    return true;
+  }
+
+  void VideoStreamServer::Activate(ClientInfo *client) {
+    if (!client->m_active) {
+      client->m_active = true;
+      client->m_deficit = 0;
+      client->m_activePosition = m_activeClients.insert(m_activeClients.end(), client);
+    }
+    if (!m_sendEvent.IsRunning()) {
+      m_sendEvent = Simulator::ScheduleNow(&VideoStreamServer::Send, this);
+    }
+  }
+
+  void VideoStreamServer::Deactivate(ClientInfo *client) {
+    if (client->m_active) {
+      client->m_active = false;
+      client->m_deficit = 0;
+      m_activeClients.erase(client->m_activePosition);
+    }
+  }
+
+  double VideoStreamServer::GetWeight(const ClientInfo *client) const {
+    if (m_weights.empty()) {
+      return 1.0;
+    }
+    return m_weights[std::min<size_t>(client->m_videoLevel, m_weights.size() - 1)];
+  }
+
+  double VideoStreamServer::GetPacingRate(const ClientInfo *client) const {
+    double rate = m_pacingRate.GetBitRate();
+    if (client->m_rateController) {
+      rate = std::min(rate, (double) client->m_rateController->GetRate().GetBitRate());
+    }
+    return rate;
+  }
+
+  void VideoStreamServer::Send(void) {
+    NS_LOG_FUNCTION(this);
+
+    NS_ASSERT(m_sendEvent.IsExpired());
+
+    Time now = Simulator::Now();
+    // A bucket shallower than a fragment would never hold the tokens to
+    // send it: every bucket holds at least one fragment of MaxPacketSize.
+    double burst = std::max(m_pacingBurst, m_maxPacketSize);
+    double serverBurst = std::max(m_serverPacingBurst, m_maxPacketSize);
+    bool serverCap = m_serverPacingRate.GetBitRate() > 0;
+    if (serverCap) {
+      m_serverTokens += m_serverPacingRate.GetBitRate() * (now - m_serverRefill).GetSeconds() / 8;
+      m_serverTokens = std::min(m_serverTokens, serverBurst);
+      m_serverRefill = now;
+    }
+
+    // Deficit round robin: the client at the head of the round gets its
+    // weighted quantum of bytes once per round, sends while its deficit
+    // covers the next fragment, then goes to the back of the round.
+    while (!m_activeClients.empty()) {
+      ClientInfo *client = m_activeClients.front();
+      uint32_t frame_idx, packet_idx;
+      bool retransmission;
+      if (!NextFragment(client, frame_idx, packet_idx, retransmission)) {
+        Deactivate(client);
+        continue;
+      }
+      SentFrame &sentFrame = GetSource(client)->m_sentFrames[frame_idx];
+      double size = GetFragmentPayload(sentFrame.m_frameSize, packet_idx) + VideoStreamHeader().GetSerializedSize();
+
+      if (!client->m_served) {
+        client->m_deficit += m_quantum * GetWeight(client);
+        client->m_served = true;
+      }
+      if (client->m_deficit < size) {
+        client->m_served = false;
+        m_activeClients.splice(m_activeClients.end(), m_activeClients, client->m_activePosition);
+        continue;
+      }
+      if (client->m_connection && client->m_connection->GetTxAvailable() < size + VideoStreamLengthHeader().GetSerializedSize()) {
+        // The TCP send buffer is full: congestion control is holding the
+        // client back, it comes back to the round once the buffer drains.
+        Deactivate(client);
+        continue;
+      }
+      // Every client has a token bucket of its own, at PacingRate or the
+      // lower rate its rate controller allows, so that no client is sent
+      // more than its own path takes however few others are backlogged.
+      double rate = GetPacingRate(client);
+      client->m_tokens += rate * (now - client->m_lastRefill).GetSeconds() / 8;
+      client->m_tokens = std::min(client->m_tokens, burst);
+      client->m_lastRefill = now;
+      if (client->m_tokens < size) {
+        // Over its own send rate: the client leaves the round until it
+        // has the tokens, the others go on.
+        Deactivate(client);
+        Simulator::Cancel(client->m_pacingEvent);
+        client->m_pacingEvent = Simulator::Schedule(Seconds((size - client->m_tokens) * 8 / rate),
+                                                    &VideoStreamServer::Activate, this, client);
+        continue;
+      }
+      if (serverCap && m_serverTokens < size) {
+        Time wait = Seconds((size - m_serverTokens) * 8 / m_serverPacingRate.GetBitRate());
+        m_sendEvent = Simulator::Schedule(wait, &VideoStreamServer::Send, this);
+        return;
+      }
+
+      SendPacket(client, frame_idx, packet_idx, sentFrame, retransmission);
+      if (GetSource(client) == client) {
+        // A repair of a multicast client leaves the group's frame alone:
+        // the other viewers of the group did not get it.
+        sentFrame.m_lastSent = now;
+      }
+      client->m_tokens -= size;
+      if (serverCap) {
+        m_serverTokens -= size;
+      }
+      client->m_deficit -= size;
+      client->m_intervalBytes += size;
+      NS_LOG_INFO("At time " << now.GetSeconds() << "s server " << (retransmission ? "resent" : "sent") << " frame " << frame_idx << " fragment " << packet_idx << " to " << PeerName(client->m_address));
+
+      if (retransmission) {
+        client->m_retransmissions.pop_front();
+        m_retransmittedFragments++;
+      } else if (++client->m_nextPacket == client->m_frameFragments) {
+        client->m_nextPacket = 0;
+        client->m_nextFrame++;
+      }
+      UpdateBacklog(client);
+    }
+  }
+
+  void VideoStreamServer::ReportFairness(void) {
+    // Every session that sent or had something to send in the interval
+    // takes part in the fairness index, the multicast groups included: they
+    // share the link with the unicast clients.
+    std::vector<ClientInfo*> sessions(m_groups);
+    for (auto iter = m_clients.begin(); iter != m_clients.end(); iter++) {
+      sessions.push_back(iter->second);
+    }
+    double sum = 0, squares = 0;
+    uint32_t count = 0;
+    for (std::vector<ClientInfo*>::iterator it = sessions.begin(); it != sessions.end(); it++) {
+      ClientInfo *client = *it;
+      if (client->m_intervalBytes == 0 && !client->m_active) {
+        continue;
+      }
+      double throughput = client->m_intervalBytes * 8 / m_fairnessInterval.GetSeconds();
+      m_clientThroughputTrace(client->m_address, throughput);
+      sum += throughput;
+      squares += throughput * throughput;
+      count++;
+      client->m_intervalBytes = 0;
+    }
+    if (count > 0 && squares > 0) {
+      double fairness = sum * sum / (count * squares);
+      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s Jain's fairness index over " << count << " sessions is " << fairness);
+      m_fairnessTrace(fairness);
+    }
+    m_fairnessEvent = Simulator::Schedule(m_fairnessInterval, &VideoStreamServer::ReportFairness, this);
+  }
+
+  void VideoStreamServer::Acknowledge(ClientInfo *client, uint32_t frame_idx) {
+    // Every frame below the client's watermark has been received.
+    if (!client->m_group) {
+      client->m_sentFrames.erase(client->m_sentFrames.begin(), client->m_sentFrames.lower_bound(frame_idx));
+    }
+  }
+
+  void VideoStreamServer::HandleNack(ClientInfo *client, const VideoStreamNackHeader &nack) {
+    NS_LOG_FUNCTION(this);
+
+    // A NACK lists everything the client is missing, so it replaces the
+    // retransmissions still queued from the previous one.
+    client->m_retransmissions.clear();
+    // A multicast client is repaired over unicast from its group's frames.
+    const ClientInfo *source = GetSource(client);
+    const std::vector<VideoStreamNackEntry> &frames = nack.GetFrames();
+    for (std::vector<VideoStreamNackEntry>::const_iterator it = frames.begin(); it != frames.end(); it++) {
+      std::map<uint32_t, SentFrame>::const_iterator sent = source->m_sentFrames.find(it->m_frameNumber);
+      if (sent == source->m_sentFrames.end()) {
+        // Not sent yet, the pacer will get to it.
+        continue;
+      }
+      if (!client->m_rtt.IsZero() && Simulator::Now() - sent->second.m_lastSent < client->m_rtt) {
+        // Sent less than a round trip ago: what is missing may still be
+        // on its way, the next NACK asks for it again if it is not.
+        continue;
+      }
+      // Only data fragments are resent, parity is not worth it.
+      uint32_t packet_count = GetFragmentCount(sent->second.m_frameSize);
+      if (it->m_frameNumber == source->m_nextFrame && source->m_nextPacket != 0) {
+        // The frame is being sent right now: only its first fragments are due.
+        packet_count = std::min(packet_count, source->m_nextPacket);
+      }
+      bool wholeFrame = it->m_fragmentCount != GetFragmentCount(sent->second.m_frameSize);
+      for (uint32_t packet_idx = 0; packet_idx < packet_count; packet_idx++) {
+        if (wholeFrame || (it->m_missing[packet_idx / 8] & (1 << (packet_idx % 8)))) {
+          client->m_retransmissions.push_back(std::make_pair(it->m_frameNumber, packet_idx));
         }
       }
     }
+    UpdateBacklog(client);
   }
 
-  void VideoStreamServer::SendPacket(ClientInfo *client, uint frame_idx, uint packet_idx) {
-    uint8_t send_Buffer[MAX_PACKET_SIZE];
-    sprintf((char *)send_Buffer, "fn:%u pn:%u", frame_idx, packet_idx);
-    Ptr<Packet> firstPacket = Create<Packet>(send_Buffer, MAX_PACKET_SIZE);
-    m_socket->Send(firstPacket);
-    if (m_socket->SendTo(firstPacket, 0, client->m_address) < 0) {
-      NS_LOG_INFO("Error while sending " << MAX_PACKET_SIZE << "bytes to " << InetSocketAddress::ConvertFrom(client->m_address).GetIpv4() << " port " << InetSocketAddress::ConvertFrom(client->m_address).GetPort());
+  void VideoStreamServer::HandleReport(ClientInfo *client, const VideoStreamHeader &header, const VideoStreamReceiverReportHeader &report) {
+    if (!header.GetEchoTime().IsZero()) {
+      // Smoothed as in RFC 6298.
+      Time rtt = Simulator::Now() - header.GetEchoTime() - report.GetHoldTime();
+      client->m_rtt = client->m_rtt.IsZero() ? rtt : Seconds(0.875 * client->m_rtt.GetSeconds() + 0.125 * rtt.GetSeconds());
+    }
+    if (!report.GetInterval().IsStrictlyPositive()) {
+      return;
+    }
+    DataRate received(static_cast<uint64_t>(report.GetReceivedBytes() * 8 / report.GetInterval().GetSeconds()));
+    // Windowed maximum as in BBR, so that intervals with little to send do
+    // not pull the estimate down.
+    client->m_deliverySamples.push_back(received.GetBitRate());
+    if (client->m_deliverySamples.size() > 10) {
+      client->m_deliverySamples.pop_front();
+    }
+    client->m_deliveryRate = *std::max_element(client->m_deliverySamples.begin(), client->m_deliverySamples.end());
+    client->m_reportInterval = report.GetInterval();
+    client->m_headroom = report.GetHeadroom();
+
+    if (client->m_started && client->m_group == 0) {
+      // The report acknowledges the frames below the watermark and slides
+      // the window, ten times a second by default rather than once.
+      if (header.GetFrameNumber() > client->m_sent) {
+        client->m_sent = header.GetFrameNumber();
+        Acknowledge(client, client->m_sent);
+      }
+      if (client->m_sent < GetTotalFrames()) {
+        StartWindow(client);
+        Activate(client);
+      }
+    }
+
+    if (client->m_rateController) {
+      DataRate rate = client->m_rateController->Update(received, report.GetLossFraction(), report.GetDelayGradient(),
+                                                       report.GetInterval(), client->m_rtt);
+      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server set the rate of " << PeerName(client->m_address)
+                  << " to " << rate.GetBitRate() << "bps, received " << received.GetBitRate() << "bps, loss " << report.GetLossFraction());
+      m_sendRateTrace(client->m_address, rate.GetBitRate());
     }
   }
 
+  void VideoStreamServer::SendManifest(ClientInfo *client) {
+    VideoStreamManifestHeader manifest;
+    manifest.SetTotalFrames(GetTotalFrames());
+    manifest.SetRepresentations(m_representations);
+    manifest.SetMaxFragments(GetMaxFragmentCount());
+    manifest.SetFec(m_fecGroupSize, m_fecParity);
+    manifest.SetMulticast(m_multicastGroup, m_multicastPort);
+    manifest.SetLive(IsLive(), m_liveStart);
+
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::MANIFEST);
+    header.SetTxTime(Simulator::Now());
+    header.SetEchoTime(client->m_lastRequestTime);
+
+    Ptr<Packet> manifestPacket = Create<Packet>();
+    manifestPacket->AddHeader(manifest);
+    manifestPacket->AddHeader(header);
+    SendMessage(client, manifestPacket);
+  }
+
+  void VideoStreamServer::SendControlAck(ClientInfo *client, const VideoStreamHeader &header) {
+    VideoStreamHeader ack;
+    ack.SetType(VideoStreamHeader::CONTROL_ACK);
+    ack.SetSequence(header.GetSequence());
+    ack.SetTxTime(Simulator::Now());
+    ack.SetEchoTime(header.GetTxTime());
+
+    Ptr<Packet> ackPacket = Create<Packet>();
+    ackPacket->AddHeader(ack);
+    SendMessage(client, ackPacket);
+  }
+
+  void VideoStreamServer::SendReset(Ptr<Socket> socket, const Address &to, const VideoStreamHeader &header) {
+    // Acknowledges the message like a CONTROL_ACK, so the client stops
+    // resending it, and tells it to request or join again. Receiver reports
+    // are not acknowledged: they get no echo time.
+    VideoStreamHeader reset;
+    reset.SetType(VideoStreamHeader::RESET);
+    reset.SetTxTime(Simulator::Now());
+    if (header.GetType() != VideoStreamHeader::RECEIVER_REPORT) {
+      reset.SetSequence(header.GetSequence());
+      reset.SetEchoTime(header.GetTxTime());
+    }
+
+    Ptr<Packet> resetPacket = Create<Packet>();
+    resetPacket->AddHeader(reset);
+    socket->SendTo(resetPacket, 0, to);
+  }
+
+  void VideoStreamServer::SendPacket(ClientInfo *client, uint frame_idx, uint packet_idx, const SentFrame &frame, bool retransmission) {
+    VideoStreamHeader header;
+    header.SetType(VideoStreamHeader::DATA);
+    header.SetLevel(frame.m_videoLevel);
+    header.SetFrameNumber(frame_idx);
+    header.SetFragmentIndex(packet_idx);
+    uint32_t fragmentCount = GetFragmentCount(frame.m_frameSize);
+    header.SetFragmentCount(fragmentCount);
+    header.SetSequence(client->m_sequence++);
+    header.SetFrameSize(frame.m_frameSize);
+    header.SetTxTime(Simulator::Now());
+    header.SetEchoTime(client->m_lastRequestTime);
+
+    // The payload is a virtual zero-filled area of the packet buffer: it is
+    // never allocated nor copied, only the header bytes are written.
+    Ptr<Packet> fragment = Create<Packet>(GetFragmentPayload(frame.m_frameSize, packet_idx));
+    fragment->AddHeader(header);
+    if (packet_idx >= fragmentCount) {
+      m_parityFragments++;
+    }
+    m_txTrace(fragment);
+    if (retransmission) {
+      m_fragmentRetransmittedTrace(fragment, client->m_address);
+    } else {
+      m_fragmentSentTrace(fragment, client->m_address);
+    }
+    if (SendMessage(client, fragment) < 0) {
+      m_droppedFragments++;
+      NS_LOG_INFO("Error while sending " << fragment->GetSize() << "bytes to " << PeerName(client->m_address));
+    }
+  }
+
+  Ptr<Socket> VideoStreamServer::GetSocket(const ClientInfo *client) const {
+    if (client->m_connection) {
+      return client->m_connection;
+    }
+    return Inet6SocketAddress::IsMatchingType(client->m_address) ? m_socket6 : m_socket;
+  }
+
+  int VideoStreamServer::SendMessage(ClientInfo *client, Ptr<Packet> message) {
+    if (client->m_connection) {
+      return client->m_connection->Send(VideoStreamFramer::Frame(message));
+    }
+    return GetSocket(client)->SendTo(message, 0, client->m_address);
+  }
+
+  VideoStreamServer::ClientInfo *VideoStreamServer::AllocateClient(const Address &from) {
+    ClientInfo *client;
+    if (m_freeClients.empty()) {
+      m_clientPool.push_back(ClientInfo());
+      client = &m_clientPool.back();
+    } else {
+      client = m_freeClients.back();
+      m_freeClients.pop_back();
+    }
+    client->m_videoLevel = 0;
+    client->m_nextFrame = 0;
+    client->m_nextPacket = 0;
+    client->m_windowEnd = 0;
+    client->m_requestEnd = 0;
+    client->m_started = false;
+    client->m_address = from;
+    client->m_backlog = 0;
+    client->m_active = false;
+    client->m_served = false;
+    client->m_deficit = 0;
+    client->m_intervalBytes = 0;
+    client->m_group = 0;
+    client->m_members = 0;
+    client->m_connection = 0;
+    client->m_sequence = 0;
+    client->m_controlSequences.clear();
+    client->m_rtt = Seconds(0);
+    client->m_deliveryRate = 0;
+    client->m_deliverySamples.clear();
+    client->m_reportInterval = Seconds(0);
+    client->m_headroom = std::numeric_limits<uint32_t>::max();
+    client->m_rateController = 0;
+    client->m_tokens = m_pacingBurst;
+    client->m_lastRefill = Simulator::Now();
+    return client;
+  }
+
+  VideoStreamServer::ClientInfo *VideoStreamServer::AddClient(const Address &from) {
+    ClientInfo *client = AllocateClient(from);
+    client->m_lastActivity = Simulator::Now();
+    client->m_idlePosition = m_idleOrder.insert(m_idleOrder.end(), client);
+    m_clients[from] = client;
+    m_sessions++;
+    if (m_rateControl && !m_stream) {
+      client->m_rateController = CreateObject<GccRateController>();
+    }
+
+    if (!m_idleTimeout.IsZero() && !m_evictEvent.IsRunning()) {
+      m_evictEvent = Simulator::Schedule(m_idleTimeout, &VideoStreamServer::EvictIdleClients, this);
+    }
+    return client;
+  }
+
+  void VideoStreamServer::RemoveClient(ClientInfo *client) {
+    NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server dropped the session of " << PeerName(client->m_address));
+
+    Deactivate(client);
+    Leave(client);
+    Simulator::Cancel(client->m_pacingEvent);
+    client->m_rateController = 0;
+    client->m_retransmissions.clear();
+    client->m_nextFrame = client->m_windowEnd = 0;
+    UpdateBacklog(client);
+    m_clients.erase(client->m_address);
+    m_idleOrder.erase(client->m_idlePosition);
+    // Keep the record, and the memory of its containers, for the next client.
+    client->m_sentFrames.clear();
+    if (client->m_connection) {
+      // The connection outlives the session: a later request starts a new one.
+      m_connections[client->m_connection].m_client = 0;
+      client->m_connection = 0;
+    }
+    m_freeClients.push_back(client);
+    m_sessions--;
+  }
+
+  void VideoStreamServer::EvictIdleClients(void) {
+    Time now = Simulator::Now();
+    while (!m_idleOrder.empty() && now - m_idleOrder.front()->m_lastActivity >= m_idleTimeout) {
+      RemoveClient(m_idleOrder.front());
+    }
+    if (!m_idleOrder.empty()) {
+      // The oldest session left is the next one to expire.
+      m_evictEvent = Simulator::Schedule(m_idleOrder.front()->m_lastActivity + m_idleTimeout - now,
+                                         &VideoStreamServer::EvictIdleClients, this);
+    }
+  }
+
+  void VideoStreamServer::HandleAccept(Ptr<Socket> socket, const Address &from) {
+    NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server accepted a connection from " << PeerName(from));
+    m_connections[socket].m_client = 0;
+    socket->SetRecvCallback(MakeCallback(&VideoStreamServer::HandleRead, this));
+    socket->SetSendCallback(MakeCallback(&VideoStreamServer::HandleSend, this));
+    socket->SetCloseCallbacks(MakeCallback(&VideoStreamServer::HandleClose, this),
+                              MakeCallback(&VideoStreamServer::HandleClose, this));
+  }
+
+  void VideoStreamServer::HandleSend(Ptr<Socket> socket, uint32_t available) {
+    // Room in the send buffer again: resume a client held back by it.
+    std::map<Ptr<Socket>, Connection>::iterator it = m_connections.find(socket);
+    if (it != m_connections.end() && it->second.m_client && it->second.m_client->m_backlog > 0) {
+      Activate(it->second.m_client);
+    }
+  }
+
+  void VideoStreamServer::HandleClose(Ptr<Socket> socket) {
+    std::map<Ptr<Socket>, Connection>::iterator it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+      return;
+    }
+    if (it->second.m_client) {
+      RemoveClient(it->second.m_client);
+    }
+    m_connections.erase(it);
+  }
+
   void VideoStreamServer::HandleRead(Ptr<Socket> socket) {
     NS_LOG_FUNCTION(this << socket);
 
     Ptr<Packet> packet;
     Address from;
-    Address localAddress;
     while ((packet = socket->RecvFrom(from)))
     {
-      socket->GetSockName(localAddress);
-      if (InetSocketAddress::IsMatchingType(from))
+      if (InetSocketAddress::IsMatchingType(from) || Inet6SocketAddress::IsMatchingType(from))
       {
-        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server received " << packet->GetSize() << " bytes from " << InetSocketAddress::ConvertFrom(from).GetIpv4() << " port " << InetSocketAddress::ConvertFrom(from).GetPort());
-
-        uint32_t ipAddr = InetSocketAddress::ConvertFrom(from).GetIpv4().Get();
-
-        uint32_t RES;
-        uint32_t LRF;
-        uint32_t FR;
-        uint8_t recvData[MAX_PACKET_SIZE];
-        packet->CopyData(recvData, MAX_PACKET_SIZE);
-        sscanf((char *)recvData, "res:%u lrf:%u fr:%u", &RES, &LRF, &FR);
-
-        if (m_clients.find(ipAddr) == m_clients.end()) {
-          ClientInfo *newClient = new ClientInfo();
-          newClient->m_sent = LRF;
-          newClient->m_videoLevel = RES;
-          newClient->m_frameRate = FR;
-          newClient->m_address = from;
-          m_clients[ipAddr] = newClient;
-          if(LRF < TOTAL_VIDEO_FRAME){
-            newClient->m_sendEvent = Simulator::Schedule(Seconds(0.0), &VideoStreamServer::Send, this, ipAddr);
-          }
-        } else {
-          NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server received video level " << RES);
-          m_clients.at(ipAddr)->m_sent = LRF;
-          m_clients.at(ipAddr)->m_videoLevel = RES;
-          m_clients.at(ipAddr)->m_frameRate = FR;
-          if(LRF < TOTAL_VIDEO_FRAME){
-            m_clients.at(ipAddr)->m_sendEvent = Simulator::Schedule(Seconds(0.0), &VideoStreamServer::Send, this, ipAddr);
-          }
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server received " << packet->GetSize() << " bytes from " << PeerName(from));
+        if (!m_stream) {
+          HandleMessage(socket, packet, from);
+          continue;
+        }
+        // Over TCP the bytes are those of a stream, cut back into messages.
+        VideoStreamFramer &framer = m_connections[socket].m_framer;
+        framer.Push(packet);
+        Ptr<Packet> message;
+        while ((message = framer.Pop())) {
+          HandleMessage(socket, message, from);
+        }
+      }
+    }
+  }
+
+  void VideoStreamServer::HandleMessage(Ptr<Socket> socket, Ptr<Packet> packet, const Address &from) {
+    VideoStreamHeader header;
+    packet->RemoveHeader(header);
+
+    ClientInfo *client;
+    std::unordered_map<Address, ClientInfo*, AddressHash>::iterator found = m_clients.find(from);
+    if (found == m_clients.end()) {
+      if (header.GetType() != VideoStreamHeader::REQUEST && header.GetType() != VideoStreamHeader::MANIFEST_REQUEST
+          && header.GetType() != VideoStreamHeader::JOIN) {
+        // The session expired while the client was still there: a control
+        // message left unanswered would be resent until the client gives up.
+        if (!m_stream && header.GetType() != VideoStreamHeader::DATA && header.GetType() != VideoStreamHeader::CONTROL_ACK
+            && header.GetType() != VideoStreamHeader::RESET) {
+          NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server reset " << PeerName(from));
+          SendReset(socket, from, header);
         }
+        return;
+      }
+      client = AddClient(from);
+      if (m_stream) {
+        client->m_connection = socket;
+        m_connections[socket].m_client = client;
+      }
+    } else {
+      client = found->second;
+      client->m_lastActivity = Simulator::Now();
+      m_idleOrder.splice(m_idleOrder.end(), m_idleOrder, client->m_idlePosition);
+    }
+    client->m_lastRequestTime = header.GetTxTime();
+
+    if (!m_stream && header.GetType() != VideoStreamHeader::RECEIVER_REPORT) {
+      // Control messages are acknowledged, duplicates too as their first
+      // acknowledgment may be lost. A message older than the last one of
+      // its type handled is stale: the newer one carried the whole state.
+      // Messages of other types do not replace it, so they do not count.
+      SendControlAck(client, header);
+      std::map<uint8_t, uint16_t>::iterator last = client->m_controlSequences.find(header.GetType());
+      if (last != client->m_controlSequences.end() && (int16_t) (header.GetSequence() - last->second) <= 0) {
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server ignored control message " << header.GetSequence() << " from " << PeerName(from));
+        return;
       }
+      client->m_controlSequences[header.GetType()] = header.GetSequence();
+    }
+
+    switch (header.GetType()) {
+      case VideoStreamHeader::REQUEST:
+        client->m_sent = header.GetFrameNumber();
+        if (IsLive() && !client->m_started) {
+          // A live stream is joined at the newest encoded frame.
+          client->m_sent = std::max(client->m_sent, m_liveFrame > 0 ? m_liveFrame - 1 : 0);
+        }
+        client->m_started = true;
+        client->m_videoLevel = std::min<uint32_t>(header.GetLevel(), m_representations.size() - 1);
+        client->m_frameRate = header.GetFrameRate();
+        Acknowledge(client, client->m_sent);
+        if (client->m_sent < GetTotalFrames()) {
+          StartWindow(client);
+          Activate(client);
+        }
+        break;
+      case VideoStreamHeader::LEVEL_CHANGE:
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server received video level " << header.GetLevel());
+        client->m_videoLevel = std::min<uint32_t>(header.GetLevel(), m_representations.size() - 1);
+        UpdateBacklog(client);
+        break;
+      case VideoStreamHeader::NACK:
+        {
+          VideoStreamNackHeader nack;
+          packet->RemoveHeader(nack);
+          Acknowledge(client, header.GetFrameNumber());
+          HandleNack(client, nack);
+          if (!client->m_retransmissions.empty()) {
+            Activate(client);
+          }
+        }
+        break;
+      case VideoStreamHeader::RECEIVER_REPORT:
+        {
+          VideoStreamReceiverReportHeader report;
+          packet->RemoveHeader(report);
+          HandleReport(client, header, report);
+        }
+        break;
+      case VideoStreamHeader::JOIN:
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s server received a join to level " << header.GetLevel());
+        Join(client, header.GetLevel());
+        break;
+      case VideoStreamHeader::MANIFEST_REQUEST:
+        SendManifest(client);
+        break;
+      default:
+        NS_LOG_WARN("Unexpected message type " << header.GetType() << " from client");
+        break;
     }
   }
 
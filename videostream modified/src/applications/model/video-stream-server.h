@@ -6,12 +6,20 @@
 #include "ns3/ptr.h"
 #include "ns3/string.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "video-frame-trace.h"
+#include "video-stream-header.h"
+#include "video-stream-framer.h"
+#include "gcc-rate-controller.h"
 
+#include <deque>
 #include <fstream>
+#include <list>
+#include <map>
 #include <unordered_map>
 
-#define MAX_PACKET_SIZE 30000 
 #define TOTAL_VIDEO_FRAME 300 
 
 namespace ns3 {
@@ -25,6 +33,21 @@ class Packet;
 
     static TypeId GetTypeId (void);
 
+    /**
+     * @brief TracedCallback signature of a client throughput report.
+     *
+     * @param address the socket address of the client
+     * @param throughput the throughput in bits per second
+     */
+    typedef void (* ThroughputCallback)(const Address &address, double throughput);
+
+    /**
+     * @brief TracedCallback signature of a fairness report.
+     *
+     * @param fairness Jain's fairness index, between 1/n and 1 for n clients
+     */
+    typedef void (* FairnessCallback)(double fairness);
+
     VideoStreamServer ();
 
     virtual ~VideoStreamServer ();
@@ -45,30 +68,221 @@ class Packet;
     virtual void StartApplication (void);
     virtual void StopApplication (void);
 
+    typedef struct SentFrame
+    {
+      uint32_t m_videoLevel;
+      uint32_t m_frameSize;
+      Time m_lastSent;        // when a fragment of the frame was last sent
+    } SentFrame;
+
     typedef struct ClientInfo
     {
       Address m_address; 
+      Time m_lastActivity;    // arrival time of the last packet from the client
+      std::list<struct ClientInfo*>::iterator m_idlePosition; // place in m_idleOrder
       uint32_t m_sent;
       uint32_t m_videoLevel;
       uint32_t m_frameRate;
-      EventId m_sendEvent;
+      Time m_lastRequestTime; // tx time of the last request, echoed in data
+      uint32_t m_windowEnd;   // first frame past the current send window
+      uint32_t m_requestEnd;  // first frame past the frames asked for, may not be encoded yet
+      bool m_started;         // has sent a request
+      uint32_t m_nextFrame;   // pacing cursor: next frame to transmit
+      uint32_t m_nextPacket;  // pacing cursor: next fragment within m_nextFrame
+      uint32_t m_frameFragments; // fragment count of m_nextFrame
+      uint32_t m_currentFrameSize; // size in bytes of m_nextFrame
+      uint32_t m_backlog;     // fragments still waiting in the pacer
+      bool m_active;          // in m_activeClients, i.e. has something to send
+      bool m_served;          // got its quantum in the current round
+      double m_deficit;       // bytes the client may still send in this round
+      uint64_t m_intervalBytes; // bytes sent since the last fairness report
+      std::list<struct ClientInfo*>::iterator m_activePosition; // place in m_activeClients
+      Ptr<Socket> m_connection; // TCP connection of the client, 0 over UDP
+      uint16_t m_sequence;    // sequence number of the next data fragment
+      std::map<uint8_t, uint16_t> m_controlSequences; // sequence number of the last control message handled, by type
+      Time m_rtt;             // smoothed round-trip time, zero until measured
+      double m_deliveryRate;  // largest received rate of the last reports, in bit/s
+      std::deque<double> m_deliverySamples; // received rates of the last reports
+      Time m_reportInterval;  // time covered by the last receiver report
+      uint32_t m_headroom;    // frames past its watermark the client can take
+      Ptr<GccRateController> m_rateController; // send rate from the receiver reports, 0 without rate control
+      double m_tokens;        // bytes the client's token bucket allows right now
+      Time m_lastRefill;
+      EventId m_pacingEvent;  // wakes the client up once it has the tokens
+      struct ClientInfo *m_group; // multicast group the client receives, 0 for unicast
+      uint32_t m_members;     // clients in the group, for a group
+      std::map<uint32_t, SentFrame> m_sentFrames; // frames sent and not yet acknowledged
+      std::deque<std::pair<uint32_t, uint32_t> > m_retransmissions; // (frame, fragment) to resend first
     } ClientInfo;
 
-    void SendPacket (ClientInfo *client, uint frame_idx, uint packet_idx);
+    typedef struct Connection
+    {
+      VideoStreamFramer m_framer;
+      ClientInfo *m_client;   // session of the connection, 0 until its first request
+    } Connection;
+
+    /**
+     * @brief Hash of a socket address, covering its type, IP address and port.
+     */
+    struct AddressHash
+    {
+      size_t operator() (const Address &address) const;
+    };
+
+    void SendPacket (ClientInfo *client, uint frame_idx, uint packet_idx, const SentFrame &frame, bool retransmission);
   
-    void Send (uint32_t ipAddress);
+    void Send (void);
+
+    bool NextFragment (ClientInfo *client, uint32_t &frame_idx, uint32_t &packet_idx, bool &retransmission);
+
+    void Activate (ClientInfo *client);
+
+    void Deactivate (ClientInfo *client);
+
+    double GetWeight (const ClientInfo *client) const;
+
+    double GetPacingRate (const ClientInfo *client) const;
+
+    void ReportFairness (void);
+
+    void StartLive (void);
+
+    void LiveTick (void);
+
+    bool IsLive (void) const;
+
+    uint32_t GetAvailableFrames (void) const;
+
+    void Join (ClientInfo *client, uint32_t level);
+
+    void Leave (ClientInfo *client);
+
+    ClientInfo *GetSource (ClientInfo *client) const;
+
+    ClientInfo *AllocateClient (const Address &from);
+
+    ClientInfo *AddClient (const Address &from);
+
+    void RemoveClient (ClientInfo *client);
+
+    void EvictIdleClients (void);
+
+    Ptr<Socket> GetSocket (const ClientInfo *client) const;
+
+    int SendMessage (ClientInfo *client, Ptr<Packet> message);
+
+    void SendManifest (ClientInfo *client);
+
+    void SendControlAck (ClientInfo *client, const VideoStreamHeader &header);
+
+    void SendReset (Ptr<Socket> socket, const Address &to, const VideoStreamHeader &header);
+
+    void StartWindow (ClientInfo *client);
+
+    uint32_t GetWindowFrames (const ClientInfo *client) const;
+
+    void UpdateBacklog (ClientInfo *client);
+
+    void HandleNack (ClientInfo *client, const VideoStreamNackHeader &nack);
+
+    void HandleReport (ClientInfo *client, const VideoStreamHeader &header, const VideoStreamReceiverReportHeader &report);
+
+    void Acknowledge (ClientInfo *client, uint32_t frame_idx);
+
+    void BuildRepresentations (void);
+
+    uint32_t GetTotalFrames (void) const;
+
+    uint32_t GetFrameSize (const ClientInfo *client, uint32_t frame_idx) const;
+
+    uint32_t GetFragmentCount (uint32_t frameSize) const;
+
+    uint32_t GetMaxFragmentCount (void) const;
+
+    uint32_t GetParityCount (uint32_t fragmentCount) const;
+
+    uint32_t GetFragmentPayload (uint32_t frameSize, uint32_t packet_idx) const;
 
     void HandleRead (Ptr<Socket> socket);
 
+    void HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from);
+
+    void HandleAccept (Ptr<Socket> socket, const Address &from);
+
+    void HandleSend (Ptr<Socket> socket, uint32_t available);
+
+    void HandleClose (Ptr<Socket> socket);
+
     Time m_interval; 
     Ptr<Socket> m_socket;
+    Ptr<Socket> m_socket6;
+    TypeId m_protocol;
+    bool m_stream;          // TCP: one connection per client, messages length prefixed
+    std::map<Ptr<Socket>, Connection> m_connections;
 
     uint16_t m_port;
     Address m_local; 
 
     std::string m_frameFile; 
-    
-    std::unordered_map<uint32_t, ClientInfo*> m_clients; 
+    Ptr<const VideoFrameTrace> m_frameTrace;
+    std::string m_representationList;
+    uint16_t m_contentFrameRate;
+    std::vector<VideoStreamRepresentation> m_representations;
+    uint32_t m_maxPacketSize;
+    uint16_t m_fecGroupSize;
+    uint16_t m_fecParity;
+
+    Time m_minWindow;
+    Time m_maxWindow;
+    double m_windowGain;
+
+    bool m_rateControl;
+    TracedCallback<const Address &, double> m_sendRateTrace;
+
+    DataRate m_pacingRate;  // of every client
+    uint32_t m_pacingBurst;
+    DataRate m_serverPacingRate; // of all clients together, 0 for no cap
+    uint32_t m_serverPacingBurst;
+    double m_serverTokens;  // server-wide token bucket fill level, in bytes
+    Time m_serverRefill;
+    EventId m_sendEvent;
+
+    uint32_t m_quantum;
+    std::string m_weightList;
+    std::vector<double> m_weights;
+    std::list<ClientInfo*> m_activeClients; // clients with fragments to send, in round order
+
+    Ipv4Address m_multicastGroup;
+    uint16_t m_multicastPort;
+    std::vector<ClientInfo*> m_groups;  // one multicast session per level
+    uint32_t m_liveFrame;               // next frame the live clock produces
+    bool m_live;
+    Time m_encodeDelay;
+    Time m_liveStart;                   // capture time of frame 0
+    EventId m_liveEvent;
+
+    Time m_fairnessInterval;
+    EventId m_fairnessEvent;
+    TracedCallback<const Address &, double> m_clientThroughputTrace;
+    TracedCallback<double> m_fairnessTrace;
+
+    TracedValue<uint32_t> m_queuedFragments;
+    TracedValue<uint32_t> m_droppedFragments;
+    TracedValue<uint32_t> m_retransmittedFragments;
+    TracedValue<uint32_t> m_parityFragments;
+
+    TracedCallback<Ptr<const Packet> > m_txTrace;
+    TracedCallback<Ptr<const Packet>, const Address &> m_fragmentSentTrace;
+    TracedCallback<Ptr<const Packet>, const Address &> m_fragmentRetransmittedTrace;
+
+    Time m_idleTimeout;
+    EventId m_evictEvent;
+    TracedValue<uint32_t> m_sessions;
+
+    std::unordered_map<Address, ClientInfo*, AddressHash> m_clients; 
+    std::deque<ClientInfo> m_clientPool;     // storage of every record, never shrinks
+    std::vector<ClientInfo*> m_freeClients;  // records of evicted clients, reused first
+    std::list<ClientInfo*> m_idleOrder;      // clients, least recently heard from first
   };
 
 } // namespace ns3
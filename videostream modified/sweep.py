@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""Run videoStreamBenchmark over a parameter grid on every local core.
+
+Run from the ns-3 root after ./waf build. Every grid point is an independent
+simulation process writing its own CSV row, so the sweep scales with the
+number of cores. The rows are gathered in <out>/results.csv, averaged over
+the seeds in <out>/summary.csv, and plotted with gnuplot when it is
+installed.
+
+    ./sweep.py --speeds 1.0,1.2,1.4,1.6,1.8,2.0 --topologies p2p,wifi --seeds 1-5
+"""
+
+import argparse
+import csv
+import itertools
+import math
+import multiprocessing
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+# Columns averaged over the seeds in the summary.
+METRICS = ["startupDelay", "stalls", "rebufferRatio", "averageBitrate", "switches", "averageLatency",
+           "goodputMbps", "fairness", "wallClockSeconds", "eventsPerSecond"]
+# Columns that identify a grid point, the seed aside.
+KEYS = ["topology", "dataRate", "delay", "clients", "speed", "abr", "adaptiveSpeed", "live", "transport", "rateControl", "packetSize"]
+
+
+def parse_list(text):
+    return [item for item in text.split(",") if item]
+
+
+def parse_seeds(text):
+    seeds = []
+    for item in parse_list(text):
+        if "-" in item:
+            first, last = item.split("-")
+            seeds.extend(range(int(first), int(last) + 1))
+        else:
+            seeds.append(int(item))
+    return seeds
+
+
+def run(job):
+    """Run one simulation, return its name, exit code and wall-clock time."""
+    name, binary, options, out, env = job
+    csv_file = os.path.join(out, "runs", name + ".csv")
+    if os.path.exists(csv_file):
+        os.remove(csv_file)
+    args = [binary] + ["--%s=%s" % item for item in options] + ["--output=" + csv_file]
+    start = time.time()
+    # The clients print their progress on stdout and the plot data on stderr.
+    with open(os.devnull, "w") as stdout, open(os.path.join(out, "runs", name + ".dat"), "w") as stderr:
+        code = subprocess.call(args, stdout=stdout, stderr=stderr, env=env)
+    return name, code, time.time() - start
+
+
+def read_rows(out, names):
+    rows = []
+    for name in names:
+        path = os.path.join(out, "runs", name + ".csv")
+        if os.path.exists(path):
+            with open(path) as f:
+                rows.extend(csv.DictReader(f))
+    return rows
+
+
+def summarize(rows):
+    groups = {}
+    for row in rows:
+        groups.setdefault(tuple(row[key] for key in KEYS), []).append(row)
+    summary = []
+    for key in sorted(groups, key=lambda k: [float(v) if v.replace(".", "", 1).isdigit() else v for v in k]):
+        group = groups[key]
+        line = dict(zip(KEYS, key))
+        line["runs"] = len(group)
+        for metric in METRICS:
+            values = [float(row[metric]) for row in group]
+            mean = sum(values) / len(values)
+            variance = sum((v - mean) ** 2 for v in values) / max(len(values) - 1, 1)
+            line[metric] = mean
+            line[metric + "Std"] = math.sqrt(variance)
+        summary.append(line)
+    return summary
+
+
+def write_csv(path, fields, rows):
+    with open(path, "w") as f:
+        writer = csv.DictWriter(f, fieldnames=fields, extrasaction="ignore")
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def plot(out, summary):
+    """Plot every metric against the speed, one line per topology."""
+    if shutil.which("gnuplot") is None:
+        print("gnuplot not found, skipping the plots")
+        return
+    topologies = sorted(set(line["topology"] for line in summary))
+    for topology in topologies:
+        with open(os.path.join(out, "summary_%s.dat" % topology), "w") as f:
+            for line in summary:
+                if line["topology"] == topology:
+                    f.write("\t".join([line["speed"]] + ["%g\t%g" % (line[m], line[m + "Std"]) for m in METRICS]) + "\n")
+    script = ["set term png", "set xlabel \"Playback speed\""]
+    for index, metric in enumerate(METRICS):
+        script.append("set output \"%s\"" % os.path.join(out, metric + ".png"))
+        script.append("set ylabel \"%s\"" % metric)
+        curves = ["\"%s\" using 1:%d:%d title \"%s\" with yerrorlines"
+                  % (os.path.join(out, "summary_%s.dat" % topology), 2 + 2 * index, 3 + 2 * index, topology)
+                  for topology in topologies]
+        script.append("plot " + ", ".join(curves))
+    process = subprocess.Popen(["gnuplot"], stdin=subprocess.PIPE)
+    process.communicate("\n".join(script).encode())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", default="build/scratch/videoStreamBenchmark/videoStreamBenchmark",
+                        help="benchmark program built by waf")
+    parser.add_argument("--out", default="sweep", help="directory of the results")
+    parser.add_argument("--jobs", type=int, default=multiprocessing.cpu_count(),
+                        help="simulations run at once, all cores by default")
+    parser.add_argument("--speeds", default="1.0,1.2,1.4,1.6,1.8,2.0")
+    parser.add_argument("--topologies", default="p2p,wifi")
+    parser.add_argument("--seeds", default="1-3", help="seeds, e.g. 1-5 or 1,4,9")
+    parser.add_argument("--dataRates", default="10Mbps")
+    parser.add_argument("--delays", default="2ms")
+    parser.add_argument("--clients", default="1")
+    parser.add_argument("--abrs", default="throughput")
+    parser.add_argument("--adaptiveSpeeds", default="0", help="0 for a constant speed, 1 for the speed controller")
+    parser.add_argument("--lives", default="0", help="0 for a stored video, 1 for a live origin")
+    parser.add_argument("--transports", default="udp", help="udp, tcp or multicast (dumbbell and wifi only)")
+    parser.add_argument("--rateControls", default="0", help="0 to pace every client at its link rate only, 1 for per-client rate control on top")
+    parser.add_argument("--packetSizes", default="1400")
+    parser.add_argument("--duration", default="100")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.binary):
+        sys.exit("%s not found: run ./waf build first" % args.binary)
+    binary = os.path.abspath(args.binary)
+    os.makedirs(os.path.join(args.out, "runs"), exist_ok=True)
+
+    # The program is linked against the ns-3 libraries of the build tree.
+    env = dict(os.environ)
+    lib = os.path.abspath(os.path.join(os.path.dirname(binary), "..", "..", "lib"))
+    env["LD_LIBRARY_PATH"] = lib + os.pathsep + env.get("LD_LIBRARY_PATH", "")
+
+    grid = itertools.product(parse_list(args.topologies), parse_list(args.dataRates), parse_list(args.delays),
+                             parse_list(args.clients), parse_list(args.speeds), parse_list(args.abrs),
+                             parse_list(args.adaptiveSpeeds), parse_list(args.lives),
+                             parse_list(args.transports), parse_list(args.rateControls), parse_list(args.packetSizes), parse_seeds(args.seeds))
+    jobs = []
+    for point in grid:
+        options = list(zip(KEYS + ["seed"], point)) + [("duration", args.duration)]
+        name = "_".join(str(value) for value in point)
+        jobs.append((name, binary, options, args.out, env))
+
+    start = time.time()
+    pool = multiprocessing.Pool(args.jobs)
+    failed = []
+    for done, (name, code, seconds) in enumerate(pool.imap_unordered(run, jobs), 1):
+        status = "ok" if code == 0 else "failed (%d)" % code
+        print("[%d/%d] %s %s in %.1fs" % (done, len(jobs), name, status, seconds))
+        if code != 0:
+            failed.append(name)
+    pool.close()
+    pool.join()
+    elapsed = time.time() - start
+
+    rows = read_rows(args.out, [job[0] for job in jobs])
+    if rows:
+        write_csv(os.path.join(args.out, "results.csv"), list(rows[0].keys()), rows)
+        summary = summarize(rows)
+        fields = KEYS + ["runs"] + [name for metric in METRICS for name in (metric, metric + "Std")]
+        write_csv(os.path.join(args.out, "summary.csv"), fields, summary)
+        plot(args.out, summary)
+    cpu = sum(float(row["wallClockSeconds"]) for row in rows)
+    print("%d runs in %.1fs on %d cores (%.1fx over running them one by one), %d failed"
+          % (len(jobs), elapsed, args.jobs, cpu / elapsed if elapsed > 0 else 0, len(failed)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())